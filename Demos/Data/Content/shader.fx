@@ -39,4 +39,92 @@ technique SpriteDrawing
 	{
 		PixelShader = compile PS_SHADERMODEL MainPS();
 	}
+};
+
+// Instanced particles from 20-byte CompactParticleInstance records (SE.Native ParticleInstances.h).
+// Stream 0 is a unit quad of corners in [0, 1]; stream 1 holds the native records, declared as:
+//   TEXCOORD1  Vector2      position
+//   TEXCOORD2  HalfVector2  scale
+//   TEXCOORD3  Short2       rotation (half float bits), frame index
+//   COLOR1     Color        packed HSLA, or RGBA8 when written with InstanceColor::Rgba
+// FrameUVs is the emitter's frame table from nativeEmitter_GetFrameUVs, raw unorm16 values as floats.
+// Tables larger than MAX_SHADER_FRAMES need splitting across draws. Requires the HiDef profile.
+#if OPENGL
+	#define INSTANCED_VS_SHADERMODEL vs_3_0
+	#define INSTANCED_PS_SHADERMODEL ps_3_0
+	#define MAX_SHADER_FRAMES 200
+#else
+	#define INSTANCED_VS_SHADERMODEL vs_4_0
+	#define INSTANCED_PS_SHADERMODEL ps_4_0
+	#define MAX_SHADER_FRAMES 1024
+#endif
+
+float4x4 ViewProjection;
+float2 TextureSize;
+float4 FrameUVs[MAX_SHADER_FRAMES];
+
+struct CompactInstanceInput
+{
+	float2 Corner : POSITION0;
+	float2 Position : TEXCOORD1;
+	float2 Scale : TEXCOORD2;
+	float2 RotationFrame : TEXCOORD3;
+	float4 Color : COLOR1;
+};
+
+// Short2 arrives signed. Returns its 16 bits as 0 to 65535.
+float unsigned16(float value)
+{
+	return value < 0.0 ? value + 65536.0 : value;
+}
+
+// Half float from its bits, in float math so it also runs on vs_3_0. Wrapped rotations are never
+// infinite or NaN.
+float halfToFloat(float bits)
+{
+	float sign = bits >= 32768.0 ? -1.0 : 1.0;
+	float magnitude = bits >= 32768.0 ? bits - 32768.0 : bits;
+	float exponent = floor(magnitude / 1024.0);
+	float mantissa = (magnitude - (exponent * 1024.0)) / 1024.0;
+	return sign * (exponent > 0.0 ? (1.0 + mantissa) * exp2(exponent - 15.0) : mantissa * exp2(-14.0));
+}
+
+VertexShaderOutput CompactInstanceVS(CompactInstanceInput input)
+{
+	float4 uv = FrameUVs[(int)unsigned16(input.RotationFrame.y)] * (1.0 / 65535.0);
+	float sine, cosine;
+	sincos(halfToFloat(unsigned16(input.RotationFrame.x)), sine, cosine);
+
+	// Rotated and scaled about the frame's center, as SpriteBatch draws particles.
+	float2 local = (input.Corner - 0.5) * (uv.zw * TextureSize * input.Scale);
+	float2 world = input.Position + float2((local.x * cosine) - (local.y * sine), (local.x * sine) + (local.y * cosine));
+
+	VertexShaderOutput output;
+	output.Position = mul(float4(world, 0.0, 1.0), ViewProjection);
+	output.Color = input.Color;
+	output.TextureCoordinates = uv.xy + (input.Corner * uv.zw);
+	return output;
+}
+
+float4 RgbaPS(VertexShaderOutput input) : COLOR
+{
+	return tex2D(SpriteTextureSampler,input.TextureCoordinates) * input.Color;
+}
+
+technique CompactInstancing
+{
+	pass P0
+	{
+		VertexShader = compile INSTANCED_VS_SHADERMODEL CompactInstanceVS();
+		PixelShader = compile INSTANCED_PS_SHADERMODEL MainPS();
+	}
+};
+
+technique CompactInstancingRgba
+{
+	pass P0
+	{
+		VertexShader = compile INSTANCED_VS_SHADERMODEL CompactInstanceVS();
+		PixelShader = compile INSTANCED_PS_SHADERMODEL RgbaPS();
+	}
 };
\ No newline at end of file
@@ -0,0 +1,130 @@
+#include "AttributeArena.h"
+#include "Particle.h"
+#include <string.h>
+
+namespace Particles {
+
+	using namespace Utility;
+
+	AttributeArena::AttributeArena() { }
+
+	const int32_t AttributeArena::getCapacity()
+	{
+		return capacity;
+	}
+
+	void AttributeArena::reserve(const int32_t newCapacity)
+	{
+		if (newCapacity <= capacity)
+			return;
+
+		relayout(newCapacity, -1);
+	}
+
+	const int32_t AttributeArena::acquire(const void* const owner, const int32_t key, const int32_t elementSize)
+	{
+		int32_t freeSlot = -1;
+		for (size_t i = 0; i < blocks.size(); i++) {
+			Block& block = blocks[i];
+			if (!block.live) {
+				freeSlot = freeSlot < 0 ? (int32_t)i : freeSlot;
+				continue;
+			}
+			if (block.owner == owner && block.key == key && block.elementSize == elementSize)
+				return (int32_t)i;
+		}
+
+		Block block;
+		block.owner = owner;
+		block.key = key;
+		block.elementSize = elementSize;
+		block.offset = 0;
+		block.live = true;
+
+		int32_t handle;
+		if (freeSlot >= 0) {
+			handle = freeSlot;
+			blocks[handle] = block;
+		} else {
+			handle = (int32_t)blocks.size();
+			blocks.push_back(block);
+		}
+
+		// Append after the live arrays if it fits, otherwise rebuild the allocation.
+		const size_t blockSize = AlignedMemory::alignSize((size_t)capacity * elementSize);
+		size_t end = 0;
+		for (size_t i = 0; i < blocks.size(); i++) {
+			const Block& other = blocks[i];
+			if (other.live && (int32_t)i != handle) {
+				const size_t otherEnd = other.offset + AlignedMemory::alignSize((size_t)capacity * other.elementSize);
+				end = otherEnd > end ? otherEnd : end;
+			}
+		}
+		if (end + blockSize <= size) {
+			blocks[handle].offset = end;
+			if (blockSize > 0)
+				memset(memory + end, 0, blockSize);
+		} else {
+			relayout(capacity, handle);
+		}
+		return handle;
+	}
+
+	const int32_t AttributeArena::acquire(const ParticleAttribute::Attribute attribute)
+	{
+		// Named attributes have no owner, so no submodule can release them. Every one is 4 bytes wide.
+		static_assert(sizeof(ParticleColor) == sizeof(float), "Named attributes must share an element size.");
+		return acquire(nullptr, (int32_t)attribute, sizeof(float));
+	}
+
+	void AttributeArena::release(const void* const owner)
+	{
+		for (Block& block : blocks) {
+			if (block.live && block.owner == owner)
+				block.live = false;
+		}
+	}
+
+	const size_t AttributeArena::getUsedSize(const int32_t forCapacity)
+	{
+		size_t used = 0;
+		for (const Block& block : blocks) {
+			if (block.live)
+				used += AlignedMemory::alignSize((size_t)forCapacity * block.elementSize);
+		}
+		return used;
+	}
+
+	void AttributeArena::relayout(const int32_t newCapacity, const int32_t freshHandle)
+	{
+		// Live arrays are packed back to back at the new capacity, which also drops released ones.
+		const size_t newSize = getUsedSize(newCapacity);
+		uint8_t* newMemory = (uint8_t*)AlignedMemory::allocate(newSize);
+		if (newSize > 0)
+			memset(newMemory, 0, newSize);
+
+		size_t offset = 0;
+		for (size_t i = 0; i < blocks.size(); i++) {
+			Block& block = blocks[i];
+			if (!block.live)
+				continue;
+
+			if ((int32_t)i != freshHandle && capacity > 0)
+				memcpy(newMemory + offset, memory + block.offset, (size_t)capacity * block.elementSize);
+
+			block.offset = offset;
+			offset += AlignedMemory::alignSize((size_t)newCapacity * block.elementSize);
+		}
+
+		AlignedMemory::free(memory);
+		memory = newMemory;
+		size = newSize;
+		capacity = newCapacity;
+	}
+
+	AttributeArena::~AttributeArena()
+	{
+		AlignedMemory::free(memory);
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,97 @@
+#pragma once
+
+#ifndef ATTRIBUTEARENA_H
+#define ATTRIBUTEARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include "src/Utility/AlignedMemory.h"
+
+namespace Particles {
+
+	// Named per-particle attributes shared by every submodule of a NativeModule. Submodules report
+	// the ones they read through getAttributes(), and the module allocates each one once and fills
+	// it once per activation, before any submodule's onParticlesActivated runs.
+	namespace ParticleAttribute {
+		enum Attribute : uint32_t {
+			None = 0,
+			StartColor = 1 << 0,	// ParticleColor at activation.
+			Random0 = 1 << 1,		// Uniform [0, 1) floats. Submodules that need independent draws use different streams.
+			Random1 = 1 << 2,
+			Random2 = 1 << 3,
+			Random3 = 1 << 4,
+			Random4 = 1 << 5,
+			Random5 = 1 << 6,
+			Random6 = 1 << 7,
+			Random7 = 1 << 8,
+			All = (1 << 9) - 1
+		};
+
+		const int32_t RANDOM_COUNT = 8;
+	}
+
+	// One cache-line aligned allocation holding the per-particle side arrays of every submodule
+	// in a NativeModule. Arrays are keyed by (owner, key): acquiring the same key again returns
+	// the same storage, so reconfiguring a submodule doesn't touch the heap.
+	// Storage moves when the arena grows. Keep the handle and resolve it with get() at the start
+	// of each update instead of caching the pointer.
+	class AttributeArena {
+	public:
+		AttributeArena();
+
+		const int32_t getCapacity();
+
+		// Grow-only. Existing contents are preserved.
+		void reserve(const int32_t capacity);
+
+		// Array of getCapacity() elements, zeroed when first created. Returns a handle for get().
+		const int32_t acquire(const void* const owner, const int32_t key, const int32_t elementSize);
+
+		// Shared array of a named attribute (see ParticleAttribute). Every caller gets the same storage.
+		const int32_t acquire(const ParticleAttribute::Attribute attribute);
+
+		// Frees every array of an owner, e.g. a removed submodule. Space is reclaimed on the next growth.
+		void release(const void* const owner);
+
+		// A negative handle (array never acquired) resolves to nullptr.
+		inline void* get(const int32_t handle)
+		{
+			if (handle < 0)
+				return nullptr;
+
+			return memory + blocks[handle].offset;
+		}
+
+		template<typename T>
+		inline T* get(const int32_t handle)
+		{
+			return static_cast<T*>(get(handle));
+		}
+
+		~AttributeArena();
+
+	private:
+		struct Block {
+			const void* owner;
+			int32_t key;
+			int32_t elementSize;
+			size_t offset;
+			bool live;
+		};
+
+		std::vector<Block> blocks;
+		uint8_t* memory = nullptr;
+		size_t size = 0;
+		int32_t capacity = 0;
+
+		const size_t getUsedSize(const int32_t forCapacity);
+		void relayout(const int32_t newCapacity, const int32_t freshHandle);
+
+		AttributeArena(const AttributeArena&) = delete;
+		AttributeArena& operator=(const AttributeArena&) = delete;
+	};
+
+}
+
+#endif
\ No newline at end of file
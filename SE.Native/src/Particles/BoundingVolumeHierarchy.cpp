@@ -0,0 +1,117 @@
+#include "BoundingVolumeHierarchy.h"
+#include <stdexcept>
+#include <algorithm>
+
+namespace Particles {
+
+	BoundingVolumeHierarchy::BoundingVolumeHierarchy() { }
+
+	void BoundingVolumeHierarchy::build(const float* const minX, const float* const minY, const float* const maxX, const float* const maxY, const int32_t length)
+	{
+		if (length < 0)
+			throw std::invalid_argument("Item count must not be negative!");
+
+		this->length = length;
+		nodes.clear();
+		if (length == 0)
+			return;
+
+		items.resize(length);
+		boxes.resize((size_t)length * 4);
+		for (int32_t i = 0; i < length; i++) {
+			items[i] = i;
+			boxes[(i * 4) + 0] = minX[i];
+			boxes[(i * 4) + 1] = minY[i];
+			boxes[(i * 4) + 2] = maxX[i];
+			boxes[(i * 4) + 3] = maxY[i];
+		}
+
+		// Nodes are split breadth-first. A node is pushed with its item range, then bounded and split
+		// when its turn comes, so children always sit next to each other.
+		nodes.push_back(Node{ 0.0f, 0.0f, 0.0f, 0.0f, 0, length });
+		const float* const box = boxes.data();
+		for (size_t current = 0; current < nodes.size(); current++) {
+			const int32_t first = nodes[current].first;
+			const int32_t count = nodes[current].count;
+			float nodeMinX = box[(items[first] * 4) + 0], nodeMinY = box[(items[first] * 4) + 1];
+			float nodeMaxX = box[(items[first] * 4) + 2], nodeMaxY = box[(items[first] * 4) + 3];
+			float centerMinX = nodeMinX + nodeMaxX, centerMinY = nodeMinY + nodeMaxY;
+			float centerMaxX = centerMinX, centerMaxY = centerMinY;
+			for (int32_t i = first; i < first + count; i++) {
+				const float* const itemBox = &box[items[i] * 4];
+				nodeMinX = itemBox[0] < nodeMinX ? itemBox[0] : nodeMinX;
+				nodeMinY = itemBox[1] < nodeMinY ? itemBox[1] : nodeMinY;
+				nodeMaxX = itemBox[2] > nodeMaxX ? itemBox[2] : nodeMaxX;
+				nodeMaxY = itemBox[3] > nodeMaxY ? itemBox[3] : nodeMaxY;
+				const float centerX = itemBox[0] + itemBox[2];
+				const float centerY = itemBox[1] + itemBox[3];
+				centerMinX = centerX < centerMinX ? centerX : centerMinX;
+				centerMinY = centerY < centerMinY ? centerY : centerMinY;
+				centerMaxX = centerX > centerMaxX ? centerX : centerMaxX;
+				centerMaxY = centerY > centerMaxY ? centerY : centerMaxY;
+			}
+			nodes[current].minX = nodeMinX;
+			nodes[current].minY = nodeMinY;
+			nodes[current].maxX = nodeMaxX;
+			nodes[current].maxY = nodeMaxY;
+			if (count <= LEAF_SIZE)
+				continue;
+
+			// Median split of the centers along the axis they spread over most. Ties are broken by item
+			// index, so the tree doesn't depend on the partitioning's internal order.
+			const int32_t axis = (centerMaxX - centerMinX) >= (centerMaxY - centerMinY) ? 0 : 1;
+			const int32_t half = count / 2;
+			std::nth_element(items.begin() + first, items.begin() + first + half, items.begin() + first + count, [box, axis](const int32_t a, const int32_t b) {
+				const float centerA = box[(a * 4) + axis] + box[(a * 4) + axis + 2];
+				const float centerB = box[(b * 4) + axis] + box[(b * 4) + axis + 2];
+				return centerA < centerB || (centerA == centerB && a < b);
+			});
+			const int32_t children = (int32_t)nodes.size();
+			nodes[current].first = children;
+			nodes[current].count = 0;
+			nodes.push_back(Node{ 0.0f, 0.0f, 0.0f, 0.0f, first, half });
+			nodes.push_back(Node{ 0.0f, 0.0f, 0.0f, 0.0f, first + half, count - half });
+		}
+	}
+
+	void BoundingVolumeHierarchy::query(const float minX, const float minY, const float maxX, const float maxY, std::vector<int32_t>& out) const
+	{
+		out.clear();
+		if (nodes.empty())
+			return;
+
+		// Balanced, so the depth is about log2(length / LEAF_SIZE) and the stack stays small.
+		int32_t stack[64];
+		int32_t top = 0;
+		stack[top++] = 0;
+		const float* const box = boxes.data();
+		while (top > 0) {
+			const Node& node = nodes[stack[--top]];
+			if (node.maxX < minX || node.maxY < minY || node.minX > maxX || node.minY > maxY)
+				continue;
+
+			if (node.count == 0) {
+				stack[top++] = node.first;
+				stack[top++] = node.first + 1;
+				continue;
+			}
+			for (int32_t i = node.first; i < node.first + node.count; i++) {
+				const int32_t item = items[i];
+				const float* const itemBox = &box[item * 4];
+				if (itemBox[2] < minX || itemBox[3] < minY || itemBox[0] > maxX || itemBox[1] > maxY)
+					continue;
+
+				out.push_back(item);
+			}
+		}
+
+		// Callers apply items in order, so the result doesn't depend on the tree's layout.
+		std::sort(out.begin(), out.end());
+	}
+
+	const int32_t BoundingVolumeHierarchy::getLength()
+	{
+		return length;
+	}
+
+}
\ No newline at end of file
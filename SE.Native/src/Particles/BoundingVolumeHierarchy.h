@@ -0,0 +1,46 @@
+#pragma once
+
+#ifndef BOUNDINGVOLUMEHIERARCHY_H
+#define BOUNDINGVOLUMEHIERARCHY_H
+
+#include "src/SE.Native.h"
+#include <stdint.h>
+#include <vector>
+
+namespace Particles {
+
+	// Binary tree of axis-aligned boxes for overlap queries against a set of items, rebuilt whenever the
+	// items move. Built top-down with median splits along the longest axis, so the tree is balanced and
+	// building is O(n log n). Buffers only grow, so rebuilding every frame doesn't allocate.
+	class BoundingVolumeHierarchy {
+	public:
+		static const int32_t LEAF_SIZE = 4;
+
+		BoundingVolumeHierarchy();
+
+		// Item i spans [minX[i], maxX[i]] x [minY[i], maxY[i]].
+		void build(const float* const minX, const float* const minY, const float* const maxX, const float* const maxY, const int32_t length);
+
+		// Replaces 'out' with the items overlapping the box, in ascending order.
+		void query(const float minX, const float minY, const float maxX, const float maxY, std::vector<int32_t>& out) const;
+
+		const int32_t getLength();
+
+	private:
+		// Leaves list items[first, first + count). Inner nodes have count 0, and their children at
+		// first and first + 1.
+		struct Node {
+			float minX, minY, maxX, maxY;
+			int32_t first;
+			int32_t count;
+		};
+
+		std::vector<Node> nodes;
+		std::vector<int32_t> items;
+		std::vector<float> boxes;		// minX, minY, maxX, maxY per item.
+		int32_t length = 0;
+	};
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,90 @@
+#include "ColorKernels.h"
+#include "src/SE.Native.h"
+#include "src/Utility/SimdKernels.h"
+
+namespace Particles {
+
+	static_assert(sizeof(ParticleColor) == sizeof(uint32_t), "ParticleColor must be a single packed uint32_t.");
+
+	namespace {
+		inline uint32_t* packed(ParticleColor* const colors)
+		{
+			return reinterpret_cast<uint32_t*>(colors);
+		}
+
+		inline const uint32_t* packed(const ParticleColor* const colors)
+		{
+			return reinterpret_cast<const uint32_t*>(colors);
+		}
+
+		// Byte position and float range of each channel, matching ParticleColor's getters.
+		const int32_t channelShift[] = { 0, 8, 16, 24 };
+		const float channelScale[] = { 360.0f, 100.0f, 100.0f, 1.0f };
+	}
+
+	void ColorKernels::setHue(ParticleColor* const colors, const float* const values, const int32_t length)
+	{
+		SimdKernels::get().setHue(packed(colors), values, length);
+	}
+
+	void ColorKernels::setSaturation(ParticleColor* const colors, const float* const values, const int32_t length)
+	{
+		SimdKernels::get().setSaturation(packed(colors), values, length);
+	}
+
+	void ColorKernels::setLightness(ParticleColor* const colors, const float* const values, const int32_t length)
+	{
+		SimdKernels::get().setLightness(packed(colors), values, length);
+	}
+
+	void ColorKernels::setAlpha(ParticleColor* const colors, const float* const values, const int32_t length)
+	{
+		SimdKernels::get().setAlpha(packed(colors), values, length);
+	}
+
+	void ColorKernels::pack(const float* const hue, const float* const saturation, const float* const lightness,
+		const float* const alpha, ParticleColor* const out, const int32_t length)
+	{
+		SimdKernels::get().packColors(hue, saturation, lightness, alpha, packed(out), length);
+	}
+
+	void ColorKernels::toRgba(const ParticleColor* const colors, uint32_t* const out, const int32_t length)
+	{
+		SimdKernels::get().toRgba(packed(colors), out, length);
+	}
+
+	void ColorKernels::lerp(const ParticleColor* const from, const int32_t* const ids, const ParticleColor to,
+		const float* const amount, ParticleColor* const out, const int32_t length)
+	{
+		SimdKernels::get().lerpColors(packed(from), ids, *packed(&to), amount, packed(out), length);
+	}
+
+	void ColorKernels::lerp(const ParticleColor* const from, const ParticleColor* const to, const int32_t* const ids,
+		const float* const amount, ParticleColor* const out, const int32_t length)
+	{
+		SimdKernels::get().lerpColorsIndexed(packed(from), packed(to), ids, amount, packed(out), length);
+	}
+
+	void ColorKernels::lerpChannel(const ParticleColor* const from, const int32_t* const ids, const ColorChannel::Channel channel,
+		const float to, const float* const amount, float* const out, const int32_t length)
+	{
+		SimdKernels::get().lerpChannel(packed(from), ids, channelShift[channel], channelScale[channel], to, amount, out, length);
+	}
+
+	void ColorKernels::lerpChannel(const ParticleColor* const from, const int32_t* const ids, const ColorChannel::Channel channel,
+		const float min, const float max, const float* const random, const float* const amount, float* const out, const int32_t length)
+	{
+		SimdKernels::get().lerpChannelRandom(packed(from), ids, channelShift[channel], channelScale[channel], min, max, random, amount, out, length);
+	}
+
+	#pragma region INTEROP METHODS.
+
+	// For managed code converting colors itself, e.g. a non-instanced draw path.
+	LIB_API(void) nativeParticles_ToRgba(const ParticleColor* const colorArrPtr, uint32_t* const rgbaArrPtr, const int32_t length)
+	{
+		ColorKernels::toRgba(colorArrPtr, rgbaArrPtr, length);
+	}
+
+	#pragma endregion
+
+}
\ No newline at end of file
@@ -0,0 +1,52 @@
+#pragma once
+
+#ifndef COLORKERNELS_H
+#define COLORKERNELS_H
+
+#include <stdint.h>
+#include "Particle.h"
+
+namespace Particles {
+
+	namespace ColorChannel {
+		enum Channel { Hue, Saturation, Lightness, Alpha };
+	}
+
+	// Array operations on packed HSLA colors. Each call unpacks, converts, clamps and repacks a
+	// whole run of colors with the best SIMD variant for the CPU (see Utility::SimdKernels).
+	// Channel values use the same units as ParticleColor: hue 0-360, saturation and lightness
+	// 0-100, alpha 0-1. Output arrays may alias the matching input color array.
+	class ColorKernels {
+	public:
+		static void setHue(ParticleColor* const colors, const float* const values, const int32_t length);
+		static void setSaturation(ParticleColor* const colors, const float* const values, const int32_t length);
+		static void setLightness(ParticleColor* const colors, const float* const values, const int32_t length);
+		static void setAlpha(ParticleColor* const colors, const float* const values, const int32_t length);
+
+		// out[i] = ParticleColor(hue[i], saturation[i], lightness[i], alpha[i]).
+		static void pack(const float* const hue, const float* const saturation, const float* const lightness,
+			const float* const alpha, ParticleColor* const out, const int32_t length);
+
+		// RGBA8 for the GPU, red in the low byte. Same conversion as the particle shader's hsl2rgb.
+		static void toRgba(const ParticleColor* const colors, uint32_t* const out, const int32_t length);
+
+		// out[i] = Lerp(from[ids[i]], to, amount[i]). 'from' is per-particle data indexed by id.
+		static void lerp(const ParticleColor* const from, const int32_t* const ids, const ParticleColor to,
+			const float* const amount, ParticleColor* const out, const int32_t length);
+
+		// out[i] = Lerp(from[ids[i]], to[ids[i]], amount[i]).
+		static void lerp(const ParticleColor* const from, const ParticleColor* const to, const int32_t* const ids,
+			const float* const amount, ParticleColor* const out, const int32_t length);
+
+		// out[i] = Lerp(channel of from[ids[i]], to, amount[i]), in channel units. 'from' is indexed by id.
+		static void lerpChannel(const ParticleColor* const from, const int32_t* const ids, const ColorChannel::Channel channel,
+			const float to, const float* const amount, float* const out, const int32_t length);
+
+		// Same, towards a per-particle end of min + (max - min) * random[ids[i]].
+		static void lerpChannel(const ParticleColor* const from, const int32_t* const ids, const ColorChannel::Channel channel,
+			const float min, const float max, const float* const random, const float* const amount, float* const out, const int32_t length);
+	};
+
+}
+
+#endif
\ No newline at end of file
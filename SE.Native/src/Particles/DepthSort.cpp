@@ -0,0 +1,115 @@
+#include "DepthSort.h"
+#include <string.h>
+
+namespace Particles {
+
+	DepthSort::DepthSort(const int32_t capacity) : capacity(capacity)
+	{
+		order = new int32_t[capacity];
+		orderIds = new int32_t[capacity];
+		indexOfId = new int32_t[capacity];
+		placed = new uint8_t[capacity];
+		keys = new float[capacity];
+		memset(indexOfId, 0, (size_t)capacity * sizeof(int32_t));
+	}
+
+	DepthSortMode::Mode DepthSort::getMode()
+	{
+		return mode;
+	}
+
+	void DepthSort::setMode(const DepthSortMode::Mode mode)
+	{
+		// The previous order is meaningless in the other direction.
+		this->mode = mode;
+		length = 0;
+	}
+
+	void DepthSort::update(ParticleBuffer* const particles, const int32_t length)
+	{
+		if (mode == DepthSortMode::None || length <= 0) {
+			this->length = 0;
+			return;
+		}
+
+		// Ascending keys draw first, so back to front sorts on negated depth.
+		const float sign = mode == DepthSortMode::BackToFront ? -1.0f : 1.0f;
+		const float* const __restrict layerDepth = particles->layerDepth;
+		const int32_t* const __restrict ids = particles->id;
+		#pragma omp simd
+		for (int32_t i = 0; i < length; i++) {
+			keys[i] = layerDepth[i] * sign;
+		}
+		for (int32_t i = 0; i < length; i++) {
+			indexOfId[ids[i]] = i;
+			placed[i] = 0;
+		}
+
+		// Replay last frame's order for particles that are still around, then append the rest.
+		// A recycled id may now belong to a new particle. That only makes the guess worse.
+		int32_t count = 0;
+		for (int32_t k = 0; k < this->length; k++) {
+			const int32_t id = orderIds[k];
+			const int32_t index = indexOfId[id];
+			if (index >= 0 && index < length && ids[index] == id && placed[index] == 0) {
+				placed[index] = 1;
+				order[count++] = index;
+			}
+		}
+		for (int32_t i = 0; i < length; i++) {
+			if (placed[i] == 0)
+				order[count++] = i;
+		}
+
+		if (!patch(length))
+			radixSort.sort(keys, length, order);
+
+		this->length = length;
+		for (int32_t k = 0; k < length; k++) {
+			orderIds[k] = ids[order[k]];
+		}
+	}
+
+	const bool DepthSort::patch(const int32_t length)
+	{
+		// Insertion sort costs one compare per particle when nothing moved, and stays cheap while
+		// few particles changed depth. Past the move budget a full radix sort is cheaper.
+		const int64_t budget = (int64_t)PATCH_MOVES_PER_PARTICLE * length;
+		int64_t moves = 0;
+		for (int32_t i = 1; i < length; i++) {
+			const int32_t index = order[i];
+			const float key = keys[index];
+			int32_t j = i;
+			while (j > 0 && keys[order[j - 1]] > key) {
+				order[j] = order[j - 1];
+				j--;
+				if (++moves > budget) {
+					order[j] = index;
+					return false;
+				}
+			}
+			order[j] = index;
+		}
+		return true;
+	}
+
+	const int32_t* DepthSort::getOrder()
+	{
+		return order;
+	}
+
+	const int32_t DepthSort::getLength()
+	{
+		return length;
+	}
+
+	DepthSort::~DepthSort()
+	{
+		delete[] order;
+		delete[] orderIds;
+		delete[] indexOfId;
+		delete[] placed;
+		delete[] keys;
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+#pragma once
+
+#ifndef DEPTHSORT_H
+#define DEPTHSORT_H
+
+#include "src/SE.Native.h"
+#include "ParticleBuffer.h"
+#include "src/Utility/RadixSort.h"
+
+namespace Particles {
+
+	namespace DepthSortMode {
+		// BackToFront draws the highest layerDepth first, like SpriteSortMode.BackToFront.
+		enum Mode : int32_t { None, BackToFront, FrontToBack };
+	}
+
+	// Draw order of an emitter's particles by layerDepth, kept from frame to frame. Particles
+	// keep their ids across frames, so last frame's order (as ids) is replayed against the
+	// current particles first. If that is still sorted nothing else runs, if it is nearly sorted
+	// an insertion pass patches it, and only otherwise is the range radix sorted from scratch.
+	class DepthSort {
+	public:
+		// Bound on element moves per particle before the insertion patch gives up for a full sort.
+		static const int32_t PATCH_MOVES_PER_PARTICLE = 4;
+
+		DepthSort(const int32_t capacity);
+
+		DepthSortMode::Mode getMode();
+		void setMode(const DepthSortMode::Mode mode);
+
+		// Sorts particles [0, length). Afterwards getOrder()[i] is the index of the i-th particle to draw.
+		void update(ParticleBuffer* const particles, const int32_t length);
+		const int32_t* getOrder();
+		const int32_t getLength();
+
+		~DepthSort();
+
+	private:
+		DepthSortMode::Mode mode = DepthSortMode::None;
+		int32_t capacity;
+		int32_t length = 0;
+		int32_t* order;
+		int32_t* orderIds;			// Ids in draw order, from the last update.
+		int32_t* indexOfId;
+		uint8_t* placed;
+		float* keys;
+		Utility::RadixSort radixSort;
+
+		const bool patch(const int32_t length);
+
+		DepthSort(const DepthSort&) = delete;
+		DepthSort& operator=(const DepthSort&) = delete;
+	};
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,124 @@
+#include "FrameTable.h"
+#include <stdexcept>
+
+namespace Particles {
+
+	namespace {
+		inline uint16_t toUnorm16(const int32_t value, const int32_t size)
+		{
+			const float normalized = (float)value / (float)size;
+			const float clamped = normalized > 0.0f ? (normalized < 1.0f ? normalized : 1.0f) : 0.0f;
+			return (uint16_t)((clamped * 65535.0f) + 0.5f);
+		}
+	}
+
+	FrameTable::FrameTable()
+	{
+		setGrid(1, 1, 1, 1);
+	}
+
+	void FrameTable::setGrid(const int32_t textureWidth, const int32_t textureHeight, const int32_t rows, const int32_t columns)
+	{
+		if (textureWidth <= 0 || textureHeight <= 0 || rows <= 0 || columns <= 0)
+			throw std::invalid_argument("Texture size and sheet dimensions must be positive!");
+		if (textureWidth < columns || textureHeight < rows)
+			throw std::invalid_argument("Texture is smaller than the sheet grid!");
+		if ((int64_t)rows * columns > MAX_FRAMES)
+			throw std::invalid_argument("Too many frames!");
+
+		this->textureWidth = textureWidth;
+		this->textureHeight = textureHeight;
+		isGrid = true;
+		gridColumns = columns;
+		cellWidth = textureWidth / columns;
+		cellHeight = textureHeight / rows;
+		rects.clear();
+		for (int32_t row = 0; row < rows; row++) {
+			for (int32_t column = 0; column < columns; column++) {
+				rects.push_back(Int4(column * cellWidth, row * cellHeight, cellWidth, cellHeight));
+			}
+		}
+		buildUVs();
+	}
+
+	void FrameTable::setFrames(const Int4* const rects, const int32_t count, const int32_t textureWidth, const int32_t textureHeight)
+	{
+		if (textureWidth <= 0 || textureHeight <= 0)
+			throw std::invalid_argument("Texture size must be positive!");
+		if (count <= 0 || count > MAX_FRAMES)
+			throw std::invalid_argument("Frame count out of range!");
+
+		this->textureWidth = textureWidth;
+		this->textureHeight = textureHeight;
+		isGrid = false;
+		this->rects.assign(rects, rects + count);
+		buildUVs();
+	}
+
+	const int32_t FrameTable::getFrameCount()
+	{
+		return (int32_t)rects.size();
+	}
+
+	const Int4 FrameTable::getFrame(const int32_t index)
+	{
+		return rects[index];
+	}
+
+	const Int4* FrameTable::getRects()
+	{
+		return rects.data();
+	}
+
+	const FrameUV* FrameTable::getUVs()
+	{
+		return uvs.data();
+	}
+
+	const int32_t FrameTable::findFrame(const int32_t x, const int32_t y, const int32_t width, const int32_t height, int32_t& hint)
+	{
+		const int32_t count = (int32_t)rects.size();
+		if (isGrid) {
+			if (width != cellWidth || height != cellHeight || x < 0 || y < 0 || x % cellWidth != 0 || y % cellHeight != 0
+				|| x / cellWidth >= gridColumns)
+				return NO_FRAME;
+
+			const int32_t index = ((y / cellHeight) * gridColumns) + (x / cellWidth);
+			return index < count ? index : NO_FRAME;
+		}
+
+		const int32_t start = hint >= 0 && hint < count ? hint : 0;
+		for (int32_t n = 0; n < count; n++) {
+			const int32_t index = (start + n) % count;
+			const Int4& rect = rects[index];
+			if (rect.x == x && rect.y == y && rect.z == width && rect.w == height) {
+				hint = index;
+				return index;
+			}
+		}
+		return NO_FRAME;
+	}
+
+	const int32_t FrameTable::getMissCount()
+	{
+		return missCount;
+	}
+
+	void FrameTable::setMissCount(const int32_t val)
+	{
+		missCount = val;
+	}
+
+	void FrameTable::buildUVs()
+	{
+		uvs.resize(rects.size());
+		for (size_t i = 0; i < rects.size(); i++) {
+			const Int4& rect = rects[i];
+			uvs[i].x = toUnorm16(rect.x, textureWidth);
+			uvs[i].y = toUnorm16(rect.y, textureHeight);
+			uvs[i].width = toUnorm16(rect.z, textureWidth);
+			uvs[i].height = toUnorm16(rect.w, textureHeight);
+		}
+	}
+
+}
\ No newline at end of file
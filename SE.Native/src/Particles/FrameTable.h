@@ -0,0 +1,68 @@
+#pragma once
+
+#ifndef FRAMETABLE_H
+#define FRAMETABLE_H
+
+#include "src/SE.Native.h"
+#include "Particle.h"
+#include <vector>
+
+namespace Particles {
+
+	// Source rectangle of one frame as 16-bit normalized texture coordinates (value / 65535).
+	struct FrameUV {
+	public:
+		uint16_t x, y, width, height;
+	};
+
+	// The texture frames an emitter draws from. Compact instances store a frame index instead of
+	// a source rectangle, and the shader reads the UVs from this table (uploaded once, not per particle).
+	// Particles keep source rectangles, so the table must list every rectangle they use: with a texture
+	// animation module, the emitter's grid has to match the module's sheet.
+	class FrameTable {
+	public:
+		static const int32_t MAX_FRAMES = 65536;
+		static const int32_t NO_FRAME = -1;
+
+		FrameTable();
+
+		// Uniform sprite sheet, frames numbered row by row from the top left.
+		void setGrid(const int32_t textureWidth, const int32_t textureHeight, const int32_t rows, const int32_t columns);
+
+		// Arbitrary frames, e.g. from a texture atlas.
+		void setFrames(const Int4* const rects, const int32_t count, const int32_t textureWidth, const int32_t textureHeight);
+
+		const int32_t getFrameCount();
+		const Int4 getFrame(const int32_t index);
+		const Int4* getRects();
+		const FrameUV* getUVs();
+
+		// Index of the frame with this source rectangle, or NO_FRAME if it isn't in the table.
+		// 'hint' is the caller's search cache (start at 0), so parallel callers don't share state.
+		const int32_t findFrame(const int32_t x, const int32_t y, const int32_t width, const int32_t height, int32_t& hint);
+
+		// Particles whose rectangle wasn't in the table during the last compact write. They're drawn
+		// as frame 0, so a non-zero count means the table and the particles' frames disagree.
+		const int32_t getMissCount();
+		void setMissCount(const int32_t val);
+
+	private:
+		std::vector<Int4> rects;
+		std::vector<FrameUV> uvs;
+		int32_t textureWidth = 1;
+		int32_t textureHeight = 1;
+
+		// Grid tables resolve frames arithmetically. Otherwise a linear search, starting from the
+		// last hit since neighboring particles tend to share frames.
+		bool isGrid = false;
+		int32_t missCount = 0;
+		int32_t gridColumns = 1;
+		int32_t cellWidth = 1;
+		int32_t cellHeight = 1;
+
+		void buildUVs();
+	};
+
+}
+
+#endif
\ No newline at end of file
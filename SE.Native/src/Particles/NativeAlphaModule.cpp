@@ -1,7 +1,7 @@
 #include "NativeAlphaModule.h"
 #include "ParticleMath.h"
 #include "Particle.h"
-#include "src/Utility/Random.h"
+#include "ColorKernels.h"
 
 namespace Particles {
 
@@ -17,57 +17,71 @@ namespace Particles {
 		if(!isRandom() || !isInitialized)
 			return;
 
-		delete[] randEndAlphas;
-		randEndAlphas = new float[particlesLength];
+		randomHandle = arena->acquire(ParticleAttribute::Random6);
 	}
 
 	void NativeAlphaModule::onInitialize(const int32_t particleArrayLength)
 	{
 		particlesLength = particleArrayLength;
-		startAlphasArr = new float[particleArrayLength];
+		startColorsHandle = arena->acquire(ParticleAttribute::StartColor);
 		isInitialized = true;
 
 		regenerateRandom();
 	}
 
-	void NativeAlphaModule::onParticlesActivated(const int32_t* const particleIndexArr, Particle* const particlesArrPtr, const int32_t length)
+	void NativeAlphaModule::onUpdate(const float deltaTime, ParticleBuffer* const buffer, const int32_t start, const int32_t end)
 	{
-		for(int32_t i = 0; i < length; i++) {
-			int32_t pIndex = particleIndexArr[i];
-			Particle* particle = &particlesArrPtr[pIndex];
-			startAlphasArr[particle->id] = particle->color.getAlpha();
-			if (!isRandom()) 
-				continue;
+		const ParticleColor* const startColors = arena->get<ParticleColor>(startColorsHandle);
+		const float* const random = arena->get<float>(randomHandle);
+		if (transition == AlphaTransition::None)
+			return;
 
-            randEndAlphas[particle->id] = ParticleMath::between(end1, end2, Random::range(0.0f, 1.0f));
+		// Alphas are computed a block at a time, then written into the packed colors in one pass.
+		const int32_t blockSize = 256;
+		float values[blockSize];
+		for (int32_t blockStart = start; blockStart < end; blockStart += blockSize) {
+			const int32_t count = (end - blockStart) < blockSize ? (end - blockStart) : blockSize;
+			const int32_t* const ids = &buffer->id[blockStart];
+			const float* const life = &buffer->life[blockStart];
+			switch (transition) {
+				case AlphaTransition::Lerp: {
+					ColorKernels::lerpChannel(startColors, ids, ColorChannel::Alpha, end1, life, values, count);
+				} break;
+				case AlphaTransition::RandomLerp: {
+					ColorKernels::lerpChannel(startColors, ids, ColorChannel::Alpha, end1, end2, random, life, values, count);
+				} break;
+				case AlphaTransition::Curve: {
+					curve->EvaluateBakedBatch(life, values, (size_t)count);
+				} break;
+				case AlphaTransition::None:
+					break;
+			}
+			ColorKernels::setAlpha(&buffer->color[blockStart], values, count);
 		}
 	}
 
-	void NativeAlphaModule::onUpdate(const float deltaTime, Particle* const particleArrPtr, const int32_t length)
-	{
-		switch(transition) {
-			case AlphaTransition::Lerp: {
-				#pragma omp simd
-				for (int32_t i = 0; i < length; i++) {
-					Particle* particle = &particleArrPtr[i];
-					particle->color.setAlpha(ParticleMath::lerp(startAlphasArr[particle->id], end1, particle->timeAlive / particle->initialLife));
-				}
-			} break;
-			case AlphaTransition::RandomLerp: {
-				#pragma omp simd
-				for (int32_t i = 0; i < length; i++) {
-					Particle* particle = &particleArrPtr[i];
-					particle->color.setAlpha(ParticleMath::lerp(startAlphasArr[particle->id], randEndAlphas[particle->id], particle->timeAlive / particle->initialLife));
-				}
-			} break;
-			case AlphaTransition::Curve: {
-				for (int32_t i = 0; i < length; i++) {
-					Particle* particle = &particleArrPtr[i];
-					particle->color.setAlpha(curve->Evaluate(particle->timeAlive / particle->initialLife));
-				}
-			} break;
-			case AlphaTransition::None:
-				break;
+	const uint32_t NativeAlphaModule::getReadStreams()
+	{
+		return ParticleStream::Id | ParticleStream::Life | ParticleStream::Color;
+	}
+
+	const uint32_t NativeAlphaModule::getWriteStreams()
+	{
+		if (transition == AlphaTransition::None)
+			return ParticleStream::None;
+
+		return ParticleStream::Color;
+	}
+
+	const uint32_t NativeAlphaModule::getAttributes()
+	{
+		switch (transition) {
+			case AlphaTransition::Lerp:
+				return ParticleAttribute::StartColor;
+			case AlphaTransition::RandomLerp:
+				return ParticleAttribute::StartColor | ParticleAttribute::Random6;
+			default:
+				return ParticleAttribute::None;
 		}
 	}
 
@@ -105,12 +119,12 @@ namespace Particles {
 			delete this->curve;
 
 		this->curve = curve;
+		if (curve != nullptr)
+			curve->EnsureBaked();
 	}
 
 	NativeAlphaModule::~NativeAlphaModule()
 	{
-		delete[] startAlphasArr;
-		delete[] randEndAlphas;
 		delete curve;
 	}
 
@@ -0,0 +1,281 @@
+#include "NativeAttractorModule.h"
+#include "ParticleMath.h"
+#include "Particle.h"
+#include "src/Utility.h"
+#include <stdexcept>
+#include <algorithm>
+#include <math.h>
+#include <cmath>
+
+namespace Particles {
+
+	namespace {
+		inline int32_t clampCell(const float value, const int32_t count)
+		{
+			const int32_t cell = (int32_t)value;
+			return cell < 0 ? 0 : (cell < count ? cell : count - 1);
+		}
+
+		// Adds one field's acceleration to every particle of a block. 'FALLOFF' is a template argument so
+		// each variant is its own branch-free loop.
+		template<int FALLOFF>
+		void accumulate(const AttractorField& field, const float* const positionX, const float* const positionY,
+			const float* const inverseMass, float* const accelerationX, float* const accelerationY, const int32_t count)
+		{
+			const float* const __restrict x = positionX;
+			const float* const __restrict y = positionY;
+			const float* const __restrict invMass = inverseMass;
+			float* const __restrict ax = accelerationX;
+			float* const __restrict ay = accelerationY;
+			const float radius = field.radius;
+			const float radiusSquared = radius * radius;
+			const float inverseRadius = 1.0f / radius;
+
+			#pragma omp simd
+			for (int32_t i = 0; i < count; i++) {
+				const float dx = field.positionX - x[i];
+				const float dy = field.positionY - y[i];
+				const float distanceSquared = (dx * dx) + (dy * dy);
+				const float distance = sqrtf(distanceSquared);
+				const float inverseDistance = 1.0f / (distance > 0.0f ? distance : 1.0f);
+				float weight = 1.0f;
+				if (FALLOFF == FieldFalloff::Linear) {
+					weight = 1.0f - (distance * inverseRadius);
+				} else if (FALLOFF == FieldFalloff::Quadratic) {
+					const float linear = 1.0f - (distance * inverseRadius);
+					weight = linear * linear;
+				}
+				// At the center dx and dy are 0, so only the radius needs masking.
+				const float inside = distanceSquared < radiusSquared ? 1.0f : 0.0f;
+				weight = weight * inside * invMass[i] * inverseDistance;
+
+				// Pull along (dx, dy), swirl along its perpendicular.
+				ax[i] += ((dx * field.strength) - (dy * field.swirl)) * weight;
+				ay[i] += ((dy * field.strength) + (dx * field.swirl)) * weight;
+			}
+		}
+
+		// Fields reaching the block being updated. One per thread, reused across frames, so it only
+		// allocates while it grows.
+		thread_local std::vector<int32_t> nearbyFields;
+	}
+
+	NativeAttractorModule::NativeAttractorModule() : NativeSubmodule() { }
+
+	void NativeAttractorModule::onInitialize(const int32_t particleArrayLength)
+	{
+		particlesLength = particleArrayLength;
+		isInitialized = true;
+	}
+
+	void NativeAttractorModule::onUpdate(const float deltaTime, ParticleBuffer* const buffer, const int32_t start, const int32_t end)
+	{
+		if (fields.empty())
+			return;
+
+		const float* const __restrict positionX = buffer->positionX;
+		const float* const __restrict positionY = buffer->positionY;
+		const float* const __restrict mass = buffer->mass;
+		float* const __restrict directionX = buffer->directionX;
+		float* const __restrict directionY = buffer->directionY;
+		float* const __restrict speed = buffer->speed;
+		const int32_t blockSize = 256;
+		float inverseMass[blockSize], accelerationX[blockSize], accelerationY[blockSize];
+		std::vector<int32_t>& nearby = nearbyFields;
+		for (int32_t blockStart = start; blockStart < end; blockStart += blockSize) {
+			const int32_t count = (end - blockStart) < blockSize ? (end - blockStart) : blockSize;
+			const float* const x = &positionX[blockStart];
+			const float* const y = &positionY[blockStart];
+
+			// Block bounds select the candidate fields from the grid.
+			float minX = x[0], minY = y[0], maxX = x[0], maxY = y[0];
+			#pragma omp simd reduction(min:minX, minY) reduction(max:maxX, maxY)
+			for (int32_t j = 0; j < count; j++) {
+				minX = x[j] < minX ? x[j] : minX;
+				minY = y[j] < minY ? y[j] : minY;
+				maxX = x[j] > maxX ? x[j] : maxX;
+				maxY = y[j] > maxY ? y[j] : maxY;
+			}
+			collectFields(minX, minY, maxX, maxY, nearby);
+			if (nearby.empty())
+				continue;
+
+			#pragma omp simd
+			for (int32_t j = 0; j < count; j++) {
+				const float particleMass = mass[blockStart + j];
+				inverseMass[j] = 1.0f / (particleMass > 0.0f ? particleMass : 1.0f);
+				accelerationX[j] = 0.0f;
+				accelerationY[j] = 0.0f;
+			}
+			for (const int32_t index : nearby) {
+				const AttractorField& field = fields[index];
+				switch (field.falloff) {
+					case FieldFalloff::Linear:
+						accumulate<FieldFalloff::Linear>(field, x, y, inverseMass, accelerationX, accelerationY, count);
+						break;
+					case FieldFalloff::Quadratic:
+						accumulate<FieldFalloff::Quadratic>(field, x, y, inverseMass, accelerationX, accelerationY, count);
+						break;
+					default:
+						accumulate<FieldFalloff::Constant>(field, x, y, inverseMass, accelerationX, accelerationY, count);
+						break;
+				}
+			}
+
+			// Same velocity update as the forces module: direction * speed, plus acceleration, split again.
+			#pragma omp simd
+			for (int32_t j = 0; j < count; j++) {
+				const int32_t i = blockStart + j;
+				const float velocityX = (directionX[i] * speed[i]) + (accelerationX[j] * deltaTime);
+				const float velocityY = (directionY[i] * speed[i]) + (accelerationY[j] * deltaTime);
+				ParticleMath::setVelocity(velocityX, velocityY, &directionX[i], &directionY[i], &speed[i]);
+			}
+		}
+	}
+
+	void NativeAttractorModule::collectFields(const float minX, const float minY, const float maxX, const float maxY, std::vector<int32_t>& out)
+	{
+		out.clear();
+		const float gridMaxX = gridMinX + (gridColumns * cellSize);
+		const float gridMaxY = gridMinY + (gridRows * cellSize);
+		if (maxX < gridMinX || maxY < gridMinY || minX > gridMaxX || minY > gridMaxY)
+			return;
+
+		const float inverseCell = 1.0f / cellSize;
+		const int32_t columnBegin = clampCell((minX - gridMinX) * inverseCell, gridColumns);
+		const int32_t columnEnd = clampCell((maxX - gridMinX) * inverseCell, gridColumns);
+		const int32_t rowBegin = clampCell((minY - gridMinY) * inverseCell, gridRows);
+		const int32_t rowEnd = clampCell((maxY - gridMinY) * inverseCell, gridRows);
+		for (int32_t row = rowBegin; row <= rowEnd; row++) {
+			for (int32_t column = columnBegin; column <= columnEnd; column++) {
+				const int32_t cell = (row * gridColumns) + column;
+				out.insert(out.end(), cellFields.begin() + cellStart[cell], cellFields.begin() + cellStart[cell + 1]);
+			}
+		}
+
+		// A field spanning several cells is listed once per cell. Sorting also keeps the order fixed.
+		std::sort(out.begin(), out.end());
+		out.erase(std::unique(out.begin(), out.end()), out.end());
+	}
+
+	void NativeAttractorModule::buildGrid()
+	{
+		gridColumns = 0;
+		gridRows = 0;
+		cellStart.clear();
+		cellFields.clear();
+		if (fields.empty())
+			return;
+
+		// Cells about the size of the largest field, grown until the grid fits MAX_GRID_CELLS.
+		float minX = fields[0].positionX, minY = fields[0].positionY, maxX = minX, maxY = minY, maxRadius = 0.0f;
+		for (const AttractorField& field : fields) {
+			minX = std::min(minX, field.positionX - field.radius);
+			minY = std::min(minY, field.positionY - field.radius);
+			maxX = std::max(maxX, field.positionX + field.radius);
+			maxY = std::max(maxY, field.positionY + field.radius);
+			maxRadius = std::max(maxRadius, field.radius);
+		}
+		gridMinX = minX;
+		gridMinY = minY;
+		cellSize = std::max(maxRadius, 1.0f);
+		while (true) {
+			gridColumns = (int32_t)((maxX - minX) / cellSize) + 1;
+			gridRows = (int32_t)((maxY - minY) / cellSize) + 1;
+			if ((int64_t)gridColumns * gridRows <= MAX_GRID_CELLS)
+				break;
+
+			cellSize *= 2.0f;
+		}
+
+		// Counting sort of (cell, field) pairs into CSR lists.
+		const int32_t cellCount = gridColumns * gridRows;
+		const float inverseCell = 1.0f / cellSize;
+		cellStart.assign(cellCount + 1, 0);
+		for (int32_t pass = 0; pass < 2; pass++) {
+			std::vector<int32_t> cursor(cellStart.begin(), cellStart.end() - 1);
+			for (int32_t index = 0; index < (int32_t)fields.size(); index++) {
+				const AttractorField& field = fields[index];
+				const int32_t columnBegin = clampCell((field.positionX - field.radius - gridMinX) * inverseCell, gridColumns);
+				const int32_t columnEnd = clampCell((field.positionX + field.radius - gridMinX) * inverseCell, gridColumns);
+				const int32_t rowBegin = clampCell((field.positionY - field.radius - gridMinY) * inverseCell, gridRows);
+				const int32_t rowEnd = clampCell((field.positionY + field.radius - gridMinY) * inverseCell, gridRows);
+				for (int32_t row = rowBegin; row <= rowEnd; row++) {
+					for (int32_t column = columnBegin; column <= columnEnd; column++) {
+						const int32_t cell = (row * gridColumns) + column;
+						if (pass == 0) {
+							cellStart[cell + 1]++;
+						} else {
+							cellFields[cursor[cell]++] = index;
+						}
+					}
+				}
+			}
+			if (pass == 0) {
+				for (int32_t cell = 0; cell < cellCount; cell++) {
+					cellStart[cell + 1] += cellStart[cell];
+				}
+				cellFields.resize(cellStart[cellCount]);
+			}
+		}
+	}
+
+	const uint32_t NativeAttractorModule::getReadStreams()
+	{
+		return ParticleStream::Position | ParticleStream::Mass | ParticleStream::Direction | ParticleStream::Speed;
+	}
+
+	const uint32_t NativeAttractorModule::getWriteStreams()
+	{
+		if (fields.empty())
+			return ParticleStream::None;
+
+		return ParticleStream::Direction | ParticleStream::Speed;
+	}
+
+	const bool NativeAttractorModule::isValid()
+	{
+		return false; // ???
+	}
+
+	void NativeAttractorModule::setFields(const AttractorField* const fields, const int32_t length)
+	{
+		if (length < 0)
+			throw std::invalid_argument("Field count must not be negative!");
+		for (int32_t i = 0; i < length; i++) {
+			const AttractorField& field = fields[i];
+			// A non-finite field would make the grid bounds NaN or infinite, and binning could never settle.
+			if (!std::isfinite(field.positionX) || !std::isfinite(field.positionY) || !std::isfinite(field.radius)
+				|| !std::isfinite(field.strength) || !std::isfinite(field.swirl))
+				throw std::invalid_argument("Field values must be finite!");
+			if (!(field.radius > 0.0f))
+				throw std::invalid_argument("Field radius must be positive!");
+		}
+
+		this->fields.assign(fields, fields + length);
+		buildGrid();
+	}
+
+	const int32_t NativeAttractorModule::getFieldCount()
+	{
+		return (int32_t)fields.size();
+	}
+
+	NativeAttractorModule::~NativeAttractorModule() { }
+
+	LIB_API(NativeAttractorModule*) nativeModule_AttractorModule_Ctor()
+	{
+		return new NativeAttractorModule();
+	}
+
+	LIB_API(void) nativeModule_AttractorModule_SetFields(NativeAttractorModule* const modulePtr, const AttractorField* const fieldArrPtr, const int32_t length)
+	{
+		modulePtr->setFields(fieldArrPtr, length);
+	}
+
+	LIB_API(int32_t) nativeModule_AttractorModule_GetFieldCount(NativeAttractorModule* const modulePtr)
+	{
+		return modulePtr->getFieldCount();
+	}
+
+}
\ No newline at end of file
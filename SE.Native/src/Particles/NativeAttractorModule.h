@@ -0,0 +1,70 @@
+#pragma once
+
+#ifndef NATIVEATTRACTORSUBMODULE_H
+#define NATIVEATTRACTORSUBMODULE_H
+
+#include "src/SE.Native.h"
+#include "Particle.h"
+#include "NativeSubmodule.h"
+#include "src/Utility.h"
+#include <vector>
+
+namespace Particles {
+
+	namespace FieldFalloff {
+		// Weight over distance inside the radius: 1, 1 - d/r, or (1 - d/r)^2.
+		enum Falloff : int32_t { Constant, Linear, Quadratic };
+	}
+
+	// A point that pulls (positive strength) or pushes (negative) particles within its radius, and
+	// optionally swirls them around it (positive is counter-clockwise on a y-down screen, clockwise
+	// with y up). Strengths are forces, divided by particle mass. The managed struct must match this
+	// layout.
+	struct AttractorField {
+	public:
+		float positionX, positionY;
+		float radius;
+		float strength;
+		float swirl;
+		FieldFalloff::Falloff falloff;
+	};
+
+	// Applies a set of attractor/repulsor fields to particles. Fields are binned into a coarse grid
+	// when set, and each block of particles only runs against the fields whose cells its bounds touch.
+	class NativeAttractorModule final : NativeSubmodule {
+	private:
+		int particlesLength;
+		std::vector<AttractorField> fields;
+
+		// Grid over the fields' bounds. Cell c lists fields cellFields[cellStart[c]] to cellFields[cellStart[c + 1]].
+		float gridMinX = 0.0f;
+		float gridMinY = 0.0f;
+		float cellSize = 1.0f;
+		int32_t gridColumns = 0;
+		int32_t gridRows = 0;
+		std::vector<int32_t> cellStart;
+		std::vector<int32_t> cellFields;
+
+		void buildGrid();
+		void collectFields(const float minX, const float minY, const float maxX, const float maxY, std::vector<int32_t>& out);
+
+	public:
+		static const int32_t MAX_GRID_CELLS = 4096;
+
+		NativeAttractorModule();
+
+		void onInitialize(const int32_t particleArrayLength) override;
+		void onUpdate(const float deltaTime, ParticleBuffer* const buffer, const int32_t start, const int32_t end) override;
+		const uint32_t getReadStreams() override;
+		const uint32_t getWriteStreams() override;
+		const bool isValid() override;
+
+		// Replaces all fields. Call again whenever fields move.
+		void setFields(const AttractorField* const fields, const int32_t length);
+		const int32_t getFieldCount();
+
+		~NativeAttractorModule() override;
+	};
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,336 @@
+#include "NativeBodyCollisionModule.h"
+#include "ParticleMath.h"
+#include "Particle.h"
+#include "src/Utility.h"
+#include <stdexcept>
+#include <math.h>
+
+namespace Particles {
+
+	namespace {
+		// Contact of a block of particles with one body: whether each touches it, how deep, and the
+		// outward normal. Particles at a circle's center back off the way they came.
+		void contactCircle(const CollisionBody& body, const float contact, const float* const positionX, const float* const positionY,
+			const float* const directionX, const float* const directionY, float* const hit, float* const penetration,
+			float* const normalX, float* const normalY, const int32_t count)
+		{
+			const float* const __restrict x = positionX;
+			const float* const __restrict y = positionY;
+			const float* const __restrict dirX = directionX;
+			const float* const __restrict dirY = directionY;
+			float* const __restrict outHit = hit;
+			float* const __restrict outPenetration = penetration;
+			float* const __restrict outX = normalX;
+			float* const __restrict outY = normalY;
+			const float reach = body.halfWidth + contact;
+
+			#pragma omp simd
+			for (int32_t j = 0; j < count; j++) {
+				const float offsetX = x[j] - body.positionX;
+				const float offsetY = y[j] - body.positionY;
+				const float distance = sqrtf((offsetX * offsetX) + (offsetY * offsetY));
+				const float inverseDistance = 1.0f / (distance > 0.0f ? distance : 1.0f);
+				const float centered = distance > 0.0f ? 0.0f : 1.0f;
+				const float depth = reach - distance;
+				outHit[j] = depth > 0.0f ? 1.0f : 0.0f;
+				outPenetration[j] = depth;
+				outX[j] = (offsetX * inverseDistance) - (dirX[j] * centered);
+				outY[j] = (offsetY * inverseDistance) - (dirY[j] * centered);
+			}
+		}
+
+		// Boxes are tested in their own frame. Outside, the normal points from the closest point on the
+		// box; inside, out of the nearest face. 'ROTATED' is false for axis-aligned boxes.
+		template<bool ROTATED>
+		void contactBox(const CollisionBody& body, const float cosine, const float sine, const float contact,
+			const float* const positionX, const float* const positionY, float* const hit, float* const penetration,
+			float* const normalX, float* const normalY, const int32_t count)
+		{
+			const float* const __restrict x = positionX;
+			const float* const __restrict y = positionY;
+			float* const __restrict outHit = hit;
+			float* const __restrict outPenetration = penetration;
+			float* const __restrict outX = normalX;
+			float* const __restrict outY = normalY;
+			const float halfWidth = body.halfWidth;
+			const float halfHeight = body.halfHeight;
+
+			#pragma omp simd
+			for (int32_t j = 0; j < count; j++) {
+				const float offsetX = x[j] - body.positionX;
+				const float offsetY = y[j] - body.positionY;
+				const float localX = ROTATED ? (offsetX * cosine) + (offsetY * sine) : offsetX;
+				const float localY = ROTATED ? (offsetY * cosine) - (offsetX * sine) : offsetY;
+				const float signX = localX < 0.0f ? -1.0f : 1.0f;
+				const float signY = localY < 0.0f ? -1.0f : 1.0f;
+				const float excessX = (localX * signX) - halfWidth;
+				const float excessY = (localY * signY) - halfHeight;
+
+				const float outsideX = excessX > 0.0f ? excessX : 0.0f;
+				const float outsideY = excessY > 0.0f ? excessY : 0.0f;
+				const float outsideDistance = sqrtf((outsideX * outsideX) + (outsideY * outsideY));
+				const float inverseOutside = 1.0f / (outsideDistance > 0.0f ? outsideDistance : 1.0f);
+				const float inside = (excessX < 0.0f && excessY < 0.0f) ? 1.0f : 0.0f;
+				const float nearestX = (excessX > excessY) ? 1.0f : 0.0f;
+				const float insideDepth = excessX > excessY ? -excessX : -excessY;
+
+				const float localNormalX = signX * ((inside * nearestX) + ((1.0f - inside) * outsideX * inverseOutside));
+				const float localNormalY = signY * ((inside * (1.0f - nearestX)) + ((1.0f - inside) * outsideY * inverseOutside));
+				const float depth = contact + (inside * insideDepth) - ((1.0f - inside) * outsideDistance);
+				outHit[j] = depth > 0.0f ? 1.0f : 0.0f;
+				outPenetration[j] = depth;
+				outX[j] = ROTATED ? (localNormalX * cosine) - (localNormalY * sine) : localNormalX;
+				outY[j] = ROTATED ? (localNormalX * sine) + (localNormalY * cosine) : localNormalY;
+			}
+		}
+
+		// Candidate bodies of the block being collided. One per thread, reused across frames, so it only
+		// allocates while it grows.
+		thread_local std::vector<int32_t> nearbyBodies;
+	}
+
+	NativeBodyCollisionModule::NativeBodyCollisionModule() : NativeSubmodule() { }
+
+	void NativeBodyCollisionModule::onInitialize(const int32_t particleArrayLength)
+	{
+		particlesLength = particleArrayLength;
+		isInitialized = true;
+	}
+
+	void NativeBodyCollisionModule::onUpdate(const float deltaTime, ParticleBuffer* const buffer, const int32_t start, const int32_t end)
+	{
+		if (bodies.empty())
+			return;
+
+		const float* const __restrict positionX = buffer->positionX;
+		const float* const __restrict positionY = buffer->positionY;
+		const float contact = radius;
+		const int32_t blockSize = BLOCK_SIZE;
+		std::vector<int32_t>& nearby = nearbyBodies;
+		for (int32_t blockStart = start; blockStart < end; blockStart += blockSize) {
+			const int32_t count = (end - blockStart) < blockSize ? (end - blockStart) : blockSize;
+			const float* const x = &positionX[blockStart];
+			const float* const y = &positionY[blockStart];
+
+			// Block bounds, grown by the contact distance, select the candidate bodies from the tree.
+			float minX = x[0], minY = y[0], maxX = x[0], maxY = y[0];
+			#pragma omp simd reduction(min:minX, minY) reduction(max:maxX, maxY)
+			for (int32_t j = 0; j < count; j++) {
+				minX = x[j] < minX ? x[j] : minX;
+				minY = y[j] < minY ? y[j] : minY;
+				maxX = x[j] > maxX ? x[j] : maxX;
+				maxY = y[j] > maxY ? y[j] : maxY;
+			}
+			tree.query(minX - contact, minY - contact, maxX + contact, maxY + contact, nearby);
+			if (nearby.size() <= MAX_BLOCK_BODIES) {
+				collide(buffer, nearby, blockStart, count);
+				continue;
+			}
+
+			// Scattered particles overlap many bodies as a block but few one by one, so each asks the
+			// tree on its own.
+			for (int32_t i = blockStart; i < blockStart + count; i++) {
+				tree.query(positionX[i] - contact, positionY[i] - contact, positionX[i] + contact, positionY[i] + contact, nearby);
+				if (!nearby.empty())
+					collide(buffer, nearby, i, 1);
+			}
+		}
+	}
+
+	void NativeBodyCollisionModule::collide(ParticleBuffer* const buffer, const std::vector<int32_t>& candidates, const int32_t blockStart, const int32_t count)
+	{
+		float* const __restrict positionX = buffer->positionX;
+		float* const __restrict positionY = buffer->positionY;
+		float* const __restrict directionX = buffer->directionX;
+		float* const __restrict directionY = buffer->directionY;
+		float* const __restrict speed = buffer->speed;
+		const float* const __restrict initialLife = buffer->initialLife;
+		float* const __restrict timeAlive = buffer->timeAlive;
+		float* const __restrict life = buffer->life;
+		const float contact = radius;
+		const float bounce = restitution;
+		const float slide = 1.0f - friction;
+		float hit[BLOCK_SIZE], penetration[BLOCK_SIZE], normalX[BLOCK_SIZE], normalY[BLOCK_SIZE];
+
+		// Every body is tested against the positions the particles came in with, and the pushes add up.
+		// A body that doesn't overlap a particle then never affects it, so the result doesn't depend on
+		// which other particles shared its block.
+		float x[BLOCK_SIZE], y[BLOCK_SIZE];
+		for (int32_t j = 0; j < count; j++) {
+			x[j] = positionX[blockStart + j];
+			y[j] = positionY[blockStart + j];
+		}
+		for (const int32_t index : candidates) {
+			const CollisionBody& body = bodies[index];
+			switch (body.shape) {
+				case BodyShape::Circle:
+					contactCircle(body, contact, x, y, &directionX[blockStart], &directionY[blockStart], hit, penetration, normalX, normalY, count);
+					break;
+				case BodyShape::Obb:
+					contactBox<true>(body, bodyRotations[index * 2], bodyRotations[(index * 2) + 1], contact, x, y, hit, penetration, normalX, normalY, count);
+					break;
+				default:
+					contactBox<false>(body, 1.0f, 0.0f, contact, x, y, hit, penetration, normalX, normalY, count);
+					break;
+			}
+
+			if (response == CollisionResponse::Kill) {
+				#pragma omp simd
+				for (int32_t j = 0; j < count; j++) {
+					const int32_t i = blockStart + j;
+					ParticleMath::kill(hit[j] > 0.0f, initialLife[i], &timeAlive[i], &life[i]);
+				}
+				continue;
+			}
+
+			// Pushed out of the body, and velocity into it reflected relative to the body's own. Particles
+			// that don't touch the body are blended back to exactly their old values.
+			const float bodyVelocityX = body.velocityX;
+			const float bodyVelocityY = body.velocityY;
+			#pragma omp simd
+			for (int32_t j = 0; j < count; j++) {
+				const int32_t i = blockStart + j;
+				const float isHit = hit[j];
+				const float nx = normalX[j];
+				const float ny = normalY[j];
+				const float push = penetration[j] * isHit;
+				positionX[i] += nx * push;
+				positionY[i] += ny * push;
+
+				const float oldDirectionX = directionX[i];
+				const float oldDirectionY = directionY[i];
+				const float oldSpeed = speed[i];
+				const float relativeX = (oldDirectionX * oldSpeed) - bodyVelocityX;
+				const float relativeY = (oldDirectionY * oldSpeed) - bodyVelocityY;
+				const float normalVelocity = (relativeX * nx) + (relativeY * ny);
+				const float approaching = isHit * (normalVelocity < 0.0f ? 1.0f : 0.0f);
+				const float tangentX = relativeX - (normalVelocity * nx);
+				const float tangentY = relativeY - (normalVelocity * ny);
+				const float velocityX = (tangentX * slide) - (nx * normalVelocity * bounce) + bodyVelocityX;
+				const float velocityY = (tangentY * slide) - (ny * normalVelocity * bounce) + bodyVelocityY;
+				float newDirectionX = oldDirectionX, newDirectionY = oldDirectionY, newSpeed;
+				ParticleMath::setVelocity(velocityX, velocityY, &newDirectionX, &newDirectionY, &newSpeed);
+				directionX[i] = oldDirectionX + ((newDirectionX - oldDirectionX) * approaching);
+				directionY[i] = oldDirectionY + ((newDirectionY - oldDirectionY) * approaching);
+				speed[i] = oldSpeed + ((newSpeed - oldSpeed) * approaching);
+			}
+		}
+	}
+
+	const uint32_t NativeBodyCollisionModule::getReadStreams()
+	{
+		if (response == CollisionResponse::Kill)
+			return ParticleStream::Position | ParticleStream::Direction | ParticleStream::Life;
+
+		return ParticleStream::Position | ParticleStream::Direction | ParticleStream::Speed;
+	}
+
+	const uint32_t NativeBodyCollisionModule::getWriteStreams()
+	{
+		if (bodies.empty())
+			return ParticleStream::None;
+		if (response == CollisionResponse::Kill)
+			return ParticleStream::Life;
+
+		return ParticleStream::Position | ParticleStream::Direction | ParticleStream::Speed;
+	}
+
+	const bool NativeBodyCollisionModule::isValid()
+	{
+		return false; // ???
+	}
+
+	void NativeBodyCollisionModule::setBodies(const CollisionBody* const bodies, const int32_t length)
+	{
+		if (length < 0)
+			throw std::invalid_argument("Body count must not be negative!");
+		for (int32_t i = 0; i < length; i++) {
+			if (!(bodies[i].halfWidth >= 0.0f) || !(bodies[i].halfHeight >= 0.0f))
+				throw std::invalid_argument("Body extents must not be negative!");
+		}
+
+		this->bodies.assign(bodies, bodies + length);
+		bodyRotations.resize((size_t)length * 2);
+		bodyBounds.resize((size_t)length * 4);
+		float* const minX = bodyBounds.data();
+		float* const minY = minX + length;
+		float* const maxX = minY + length;
+		float* const maxY = maxX + length;
+		for (int32_t i = 0; i < length; i++) {
+			const CollisionBody& body = bodies[i];
+			float extentX = body.halfWidth, extentY = body.halfHeight;
+			bodyRotations[i * 2] = 1.0f;
+			bodyRotations[(i * 2) + 1] = 0.0f;
+			if (body.shape == BodyShape::Circle) {
+				extentY = body.halfWidth;
+			} else if (body.shape == BodyShape::Obb) {
+				const float cosine = cosf(body.rotation);
+				const float sine = sinf(body.rotation);
+				bodyRotations[i * 2] = cosine;
+				bodyRotations[(i * 2) + 1] = sine;
+				extentX = (fabsf(cosine) * body.halfWidth) + (fabsf(sine) * body.halfHeight);
+				extentY = (fabsf(sine) * body.halfWidth) + (fabsf(cosine) * body.halfHeight);
+			}
+			minX[i] = body.positionX - extentX;
+			minY[i] = body.positionY - extentY;
+			maxX[i] = body.positionX + extentX;
+			maxY[i] = body.positionY + extentY;
+		}
+		tree.build(minX, minY, maxX, maxY, length);
+	}
+
+	const int32_t NativeBodyCollisionModule::getBodyCount()
+	{
+		return (int32_t)bodies.size();
+	}
+
+	void NativeBodyCollisionModule::setBounce(const float restitution, const float friction)
+	{
+		response = CollisionResponse::Bounce;
+		this->restitution = restitution > 0.0f ? restitution : 0.0f;
+		this->friction = friction < 0.0f ? 0.0f : (friction > 1.0f ? 1.0f : friction);
+	}
+
+	void NativeBodyCollisionModule::setKill()
+	{
+		response = CollisionResponse::Kill;
+	}
+
+	void NativeBodyCollisionModule::setRadius(const float radius)
+	{
+		this->radius = radius > 0.0f ? radius : 0.0f;
+	}
+
+	NativeBodyCollisionModule::~NativeBodyCollisionModule() { }
+
+	LIB_API(NativeBodyCollisionModule*) nativeModule_BodyCollisionModule_Ctor()
+	{
+		return new NativeBodyCollisionModule();
+	}
+
+	LIB_API(void) nativeModule_BodyCollisionModule_SetBodies(NativeBodyCollisionModule* const modulePtr, const CollisionBody* const bodyArrPtr, const int32_t length)
+	{
+		modulePtr->setBodies(bodyArrPtr, length);
+	}
+
+	LIB_API(int32_t) nativeModule_BodyCollisionModule_GetBodyCount(NativeBodyCollisionModule* const modulePtr)
+	{
+		return modulePtr->getBodyCount();
+	}
+
+	LIB_API(void) nativeModule_BodyCollisionModule_SetBounce(NativeBodyCollisionModule* const modulePtr, const float restitution, const float friction)
+	{
+		modulePtr->setBounce(restitution, friction);
+	}
+
+	LIB_API(void) nativeModule_BodyCollisionModule_SetKill(NativeBodyCollisionModule* const modulePtr)
+	{
+		modulePtr->setKill();
+	}
+
+	LIB_API(void) nativeModule_BodyCollisionModule_SetRadius(NativeBodyCollisionModule* const modulePtr, const float radius)
+	{
+		modulePtr->setRadius(radius);
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,80 @@
+#pragma once
+
+#ifndef NATIVEBODYCOLLISIONMODULE_H
+#define NATIVEBODYCOLLISIONMODULE_H
+
+#include "src/SE.Native.h"
+#include "Particle.h"
+#include "NativeSubmodule.h"
+#include "NativeWorldCollisionModule.h"
+#include "BoundingVolumeHierarchy.h"
+#include "src/Utility.h"
+#include <vector>
+
+namespace Particles {
+
+	namespace BodyShape {
+		enum Shape : int32_t { Circle, Aabb, Obb };
+	}
+
+	// A physics body as particles see it. Circles use halfWidth as their radius, and only Obb uses the
+	// rotation (radians, about the center). Velocity is carried into bounced particles. The managed
+	// struct must match this layout.
+	struct CollisionBody {
+	public:
+		float positionX, positionY;
+		float halfWidth, halfHeight;
+		float rotation;
+		float velocityX, velocityY;
+		BodyShape::Shape shape;
+	};
+
+	// Collides particles with moving bodies, set every frame. The bodies go into a bounding volume
+	// hierarchy, and each block of particles only tests the bodies overlapping its bounds, one
+	// vectorized pass per body in list order. Blocks whose bounds overlap too many bodies query the
+	// tree per particle instead. Responses work as in the world collision module, with velocities
+	// relative to the body.
+	class NativeBodyCollisionModule final : NativeSubmodule {
+	public:
+		static const int32_t BLOCK_SIZE = 256;
+		// Beyond this many candidates a block's particles are too scattered to test together.
+		static const size_t MAX_BLOCK_BODIES = 8;
+
+	private:
+		int particlesLength;
+		std::vector<CollisionBody> bodies;
+		std::vector<float> bodyRotations;		// Cosine and sine per body.
+		std::vector<float> bodyBounds;		// minX, minY, maxX, maxY rows of bodies.size().
+		BoundingVolumeHierarchy tree;
+
+		CollisionResponse::Response response = CollisionResponse::Bounce;
+		float restitution = 0.5f;
+		float friction = 0.0f;
+		float radius = 0.0f;
+
+		void collide(ParticleBuffer* const buffer, const std::vector<int32_t>& candidates, const int32_t blockStart, const int32_t count);
+
+	public:
+		NativeBodyCollisionModule();
+
+		void onInitialize(const int32_t particleArrayLength) override;
+		void onUpdate(const float deltaTime, ParticleBuffer* const buffer, const int32_t start, const int32_t end) override;
+		const uint32_t getReadStreams() override;
+		const uint32_t getWriteStreams() override;
+		const bool isValid() override;
+
+		// Replaces all bodies and rebuilds the tree. Call every frame the bodies move.
+		void setBodies(const CollisionBody* const bodies, const int32_t length);
+		const int32_t getBodyCount();
+
+		void setBounce(const float restitution, const float friction);
+		void setKill();
+
+		// Distance from a body at which particles collide.
+		void setRadius(const float radius);
+
+		~NativeBodyCollisionModule() override;
+	};
+}
+
+#endif
\ No newline at end of file
@@ -1,10 +1,15 @@
 #include "NativeColorModule.h"
 #include "ParticleMath.h"
 #include "Particle.h"
-#include "src/Utility/Random.h"
+#include "ColorKernels.h"
 
 namespace Particles {
 
+	// The channel modules' random lerps draw from the same streams.
+	const ParticleAttribute::Attribute NativeColorModule::randomAttributes[4] = {
+		ParticleAttribute::Random3, ParticleAttribute::Random4, ParticleAttribute::Random5, ParticleAttribute::Random6
+	};
+
 	bool NativeColorModule::isRandom()
 	{
 		return transition == ColorTransition::RandomLerp;
@@ -17,61 +22,80 @@ namespace Particles {
 		if (!isRandom() || !isInitialized)
 			return;
 
-		delete[] randEndColors;
-		randEndColors = new ParticleColor[particlesLength];
+		randEndColorsHandle = arena->acquire(this, 1, sizeof(ParticleColor));
+		for (int32_t i = 0; i < 4; i++) {
+			randomHandles[i] = arena->acquire(randomAttributes[i]);
+		}
 	}
 
 	void NativeColorModule::onInitialize(const int32_t particleArrayLength)
 	{
 		particlesLength = particleArrayLength;
-		startColorsArr = new ParticleColor[particleArrayLength];
+		startColorsHandle = arena->acquire(ParticleAttribute::StartColor);
 		isInitialized = true;
 
 		regenerateRandom();
 	}
 
-	void NativeColorModule::onParticlesActivated(const int32_t* const particleIndexArr, Particle* const particlesArrPtr, const int32_t length)
+	void NativeColorModule::onParticlesActivated(ParticleBuffer* const buffer, RandomStream& random, const int32_t start, const int32_t end)
 	{
-		for (int32_t i = 0; i < length; i++) {
-			int32_t pIndex = particleIndexArr[i];
-			Particle* particle = &particlesArrPtr[pIndex];
-			startColorsArr[particle->id] = particle->color;
-			if (!isRandom())
-				continue;
+		if (!isRandom())
+			return;
 
-			randEndColors[particle->id] = ParticleColor(
-				ParticleMath::between(end1.getHue(), end2.getHue(), Random::range(0.0f, 1.0f)),
-				ParticleMath::between(end1.getSaturation(), end2.getSaturation(), Random::range(0.0f, 1.0f)),
-				ParticleMath::between(end1.getLightness(), end2.getLightness(), Random::range(0.0f, 1.0f)),
-				ParticleMath::between(end1.getAlpha(), end2.getAlpha(), Random::range(0.0f, 1.0f)));
+		// Random end colors are built from the shared per-channel draws a block at a time, then scattered by id.
+		ParticleColor* const randEndColors = arena->get<ParticleColor>(randEndColorsHandle);
+		const float* const randomHue = arena->get<float>(randomHandles[0]);
+		const float* const randomSaturation = arena->get<float>(randomHandles[1]);
+		const float* const randomLightness = arena->get<float>(randomHandles[2]);
+		const float* const randomAlpha = arena->get<float>(randomHandles[3]);
+		const int32_t* const __restrict ids = buffer->id;
+		const float hueMin = end1.getHue(), hueDelta = end2.getHue() - hueMin;
+		const float saturationMin = end1.getSaturation(), saturationDelta = end2.getSaturation() - saturationMin;
+		const float lightnessMin = end1.getLightness(), lightnessDelta = end2.getLightness() - lightnessMin;
+		const float alphaMin = end1.getAlpha(), alphaDelta = end2.getAlpha() - alphaMin;
+		const int32_t blockSize = 256;
+		float hue[blockSize], saturation[blockSize], lightness[blockSize], alpha[blockSize];
+		ParticleColor packed[blockSize];
+		for (int32_t blockStart = start; blockStart < end; blockStart += blockSize) {
+			const int32_t count = (end - blockStart) < blockSize ? (end - blockStart) : blockSize;
+			const int32_t* const blockIds = &ids[blockStart];
+			#pragma omp simd
+			for (int32_t j = 0; j < count; j++) {
+				const int32_t pId = blockIds[j];
+				hue[j] = hueMin + (hueDelta * randomHue[pId]);
+				saturation[j] = saturationMin + (saturationDelta * randomSaturation[pId]);
+				lightness[j] = lightnessMin + (lightnessDelta * randomLightness[pId]);
+				alpha[j] = alphaMin + (alphaDelta * randomAlpha[pId]);
+			}
+			ColorKernels::pack(hue, saturation, lightness, alpha, packed, count);
+			for (int32_t j = 0; j < count; j++) {
+				randEndColors[blockIds[j]] = packed[j];
+			}
 		}
 	}
 
-	void NativeColorModule::onUpdate(const float deltaTime, Particle* const particleArrPtr, const int32_t length)
+	void NativeColorModule::onUpdate(const float deltaTime, ParticleBuffer* const buffer, const int32_t start, const int32_t end)
 	{
+		const ParticleColor* const startColorsArr = arena->get<ParticleColor>(startColorsHandle);
+		const ParticleColor* const randEndColors = arena->get<ParticleColor>(randEndColorsHandle);
+		const int32_t* const __restrict ids = buffer->id;
+		const float* const __restrict life = buffer->life;
+		ParticleColor* const __restrict colors = buffer->color;
 		switch (transition) {
 			case ColorTransition::Lerp: {
-				for (int32_t i = 0; i < length; i++) {
-					Particle* particle = &particleArrPtr[i];
-					const float life = particle->timeAlive / particle->initialLife;
-					int32_t pId = particleArrPtr[i].id;
-					particle->color = ParticleColor::Lerp(startColorsArr[pId], end1, life);
-				}
+				ColorKernels::lerp(startColorsArr, &ids[start], end1, &life[start], &colors[start], end - start);
 			} break;
 			case ColorTransition::RandomLerp: {
-				for (int32_t i = 0; i < length; i++) {
-					Particle* particle = &particleArrPtr[i];
-					const float life = particle->timeAlive / particle->initialLife;
-					int32_t pId = particleArrPtr[i].id;
-					particle->color = ParticleColor::Lerp(startColorsArr[pId], randEndColors[pId], life);
-				}
+				ColorKernels::lerp(startColorsArr, randEndColors, &ids[start], &life[start], &colors[start], end - start);
 			} break;
 			case ColorTransition::Curve: {
-				for (int32_t i = 0; i < length; i++) {
-					Particle* particle = &particleArrPtr[i];
-					const float life = particle->timeAlive / particle->initialLife;
-					Vector4 vec = curve->Evaluate(life);
-					particle->color = ParticleColor(vec.x, vec.y, vec.z, vec.w);
+				// Evaluate all four channels for a block of particles at once, then pack.
+				const int32_t blockSize = 256;
+				float hue[blockSize], saturation[blockSize], lightness[blockSize], alpha[blockSize];
+				for (int32_t blockStart = start; blockStart < end; blockStart += blockSize) {
+					const int32_t count = (end - blockStart) < blockSize ? (end - blockStart) : blockSize;
+					curve->EvaluateBakedBatch(&life[blockStart], hue, saturation, lightness, alpha, (size_t)count);
+					ColorKernels::pack(hue, saturation, lightness, alpha, &colors[blockStart], count);
 				}
 			} break;
 			case ColorTransition::None:
@@ -79,6 +103,31 @@ namespace Particles {
 		}
 	}
 
+	const uint32_t NativeColorModule::getReadStreams()
+	{
+		return ParticleStream::Id | ParticleStream::Life | ParticleStream::Color;
+	}
+
+	const uint32_t NativeColorModule::getWriteStreams()
+	{
+		if (transition == ColorTransition::None)
+			return ParticleStream::None;
+
+		return ParticleStream::Color;
+	}
+
+	const uint32_t NativeColorModule::getAttributes()
+	{
+		switch (transition) {
+			case ColorTransition::Lerp:
+				return ParticleAttribute::StartColor;
+			case ColorTransition::RandomLerp:
+				return ParticleAttribute::StartColor | randomAttributes[0] | randomAttributes[1] | randomAttributes[2] | randomAttributes[3];
+			default:
+				return ParticleAttribute::None;
+		}
+	}
+
 	const bool NativeColorModule::isValid()
 	{
 		return false; // ???
@@ -119,12 +168,12 @@ namespace Particles {
 			delete this->curve;
 
 		this->curve = curve;
+		if (curve != nullptr)
+			curve->EnsureBaked();
 	}
 
 	NativeColorModule::~NativeColorModule()
 	{
-		delete[] startColorsArr;
-		delete[] randEndColors;
 		delete curve;
 	}
 
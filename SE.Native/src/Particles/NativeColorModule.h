@@ -19,8 +19,11 @@ namespace Particles {
 		ColorTransition::Transition transition = ColorTransition::None;
 		int particlesLength;
 		ParticleColor end1, end2;
-		ParticleColor* startColorsArr = nullptr;
-		ParticleColor* randEndColors = nullptr;
+		// Per-particle side arrays and shared attributes, as handles into the module's AttributeArena.
+		int32_t startColorsHandle = -1;
+		int32_t randEndColorsHandle = -1;
+		int32_t randomHandles[4] = { -1, -1, -1, -1 };
+		static const ParticleAttribute::Attribute randomAttributes[4];
 		Curve4* curve = nullptr;
 
 		void regenerateRandom();
@@ -30,8 +33,11 @@ namespace Particles {
 		NativeColorModule();
 
 		void onInitialize(const int32_t particleArrayLength) override;
-		void onParticlesActivated(const int32_t* const particleIndexArr, Particle* const particlesArrPtr, const int32_t length) override;
-		void onUpdate(float deltaTime, Particle* const particleArrPtr, const int32_t length) override;
+		void onParticlesActivated(ParticleBuffer* const buffer, RandomStream& random, const int32_t start, const int32_t end) override;
+		void onUpdate(const float deltaTime, ParticleBuffer* const buffer, const int32_t start, const int32_t end) override;
+		const uint32_t getReadStreams() override;
+		const uint32_t getWriteStreams() override;
+		const uint32_t getAttributes() override;
 		const bool isValid() override;
 
 		void setNone();
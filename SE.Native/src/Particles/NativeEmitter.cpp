@@ -0,0 +1,404 @@
+#include "NativeEmitter.h"
+#include "src/Utility/ThreadPool.h"
+#include "src/Utility/SimdKernels.h"
+#include <stdexcept>
+#include <string.h>
+
+namespace Particles {
+
+	NativeEmitter::NativeEmitter(const int32_t capacity) : capacity(capacity)
+	{
+		if (capacity <= 0)
+			throw std::invalid_argument("Emitter capacity must be positive!");
+
+		module = new NativeModule();
+		particles.resize(capacity);
+		freeIds = new int32_t[capacity];
+		liveMask = new uint8_t[(capacity + 7) / 8];
+		visibleMask = new uint8_t[(capacity + 7) / 8];
+		visibleIndices = new int32_t[capacity];
+		depthSort = new DepthSort(capacity);
+		frames = new FrameTable();
+		clear();
+	}
+
+	NativeModule* NativeEmitter::getModule()
+	{
+		return module;
+	}
+
+	const int32_t NativeEmitter::getCapacity()
+	{
+		return capacity;
+	}
+
+	const int32_t NativeEmitter::getActiveCount()
+	{
+		return activeCount;
+	}
+
+	ParticleBuffer* NativeEmitter::getParticles()
+	{
+		return &particles;
+	}
+
+	const int32_t NativeEmitter::emit(const Particle* const particleArrPtr, const int32_t length)
+	{
+		const int32_t count = length < freeCount ? length : freeCount;
+		if (count <= 0)
+			return 0;
+
+		// New particles are appended after the live range, taking their ids from the free list.
+		const int32_t start = activeCount;
+		for (int32_t i = 0; i < count; i++) {
+			Particle particle = particleArrPtr[i];
+			particle.id = freeIds[--freeCount];
+			particles.setParticle(start + i, particle);
+		}
+		activeCount += count;
+
+		module->onParticlesActivated(&particles, start, activeCount);
+		return count;
+	}
+
+	void NativeEmitter::onUpdate(const float deltaTime)
+	{
+		integrate(deltaTime);
+		retireDead();
+		module->onUpdate(deltaTime, &particles, activeCount);
+		depthSort->update(&particles, activeCount);
+	}
+
+	void NativeEmitter::integrate(const float deltaTime)
+	{
+		ThreadPool::get().parallelFor(0, activeCount, module->getChunkSize(), [this, deltaTime](const int32_t start, const int32_t end) {
+			float* const __restrict positionX = particles.positionX;
+			float* const __restrict positionY = particles.positionY;
+			const float* const __restrict directionX = particles.directionX;
+			const float* const __restrict directionY = particles.directionY;
+			const float* const __restrict speed = particles.speed;
+			const float* const __restrict initialLife = particles.initialLife;
+			float* const __restrict timeAlive = particles.timeAlive;
+			float* const __restrict life = particles.life;
+
+			#pragma omp simd
+			for (int32_t i = start; i < end; i++) {
+				const float distance = speed[i] * deltaTime;
+				positionX[i] += directionX[i] * distance;
+				positionY[i] += directionY[i] * distance;
+				timeAlive[i] += deltaTime;
+				life[i] = timeAlive[i] / initialLife[i];
+			}
+		});
+	}
+
+	void NativeEmitter::retireDead()
+	{
+		const KernelTable& kernels = SimdKernels::get();
+		const int32_t liveCount = kernels.buildLiveMask(particles.timeAlive, particles.initialLife, liveMask, activeCount);
+		if (liveCount == activeCount)
+			return;
+
+		// Ids are recycled before the id stream is compacted. They travel with their particles,
+		// so id-indexed submodule state stays valid without remapping.
+		const int32_t* const ids = particles.id;
+		for (int32_t byte = 0; byte < (activeCount + 7) / 8; byte++) {
+			if (liveMask[byte] == 0xff)
+				continue;
+
+			const int32_t end = (byte * 8) + 8 < activeCount ? (byte * 8) + 8 : activeCount;
+			for (int32_t i = byte * 8; i < end; i++) {
+				if ((liveMask[byte] & (1 << (i & 7))) == 0)
+					freeIds[freeCount++] = ids[i];
+			}
+		}
+
+		// Left-pack every stream. Streams are independent, so they are spread over the pool.
+		const int32_t length = activeCount;
+		ThreadPool::get().parallelForEach(0, ParticleBuffer::STREAM_COUNT, [this, &kernels, length](const int32_t begin, const int32_t end) {
+			for (int32_t stream = begin; stream < end; stream++) {
+				kernels.compact(particles.getStream(stream), liveMask, length);
+			}
+		});
+		activeCount = liveCount;
+	}
+
+	const int32_t NativeEmitter::copyTo(Particle* const particleArrPtr, const int32_t maxLength)
+	{
+		const int32_t count = activeCount < maxLength ? activeCount : maxLength;
+		if (count <= 0)
+			return 0;
+
+		particles.writeTo(particleArrPtr, 0, count, ParticleStream::All);
+		return count;
+	}
+
+	const int32_t* NativeEmitter::getSortedOrder()
+	{
+		if (depthSort->getMode() == DepthSortMode::None)
+			return nullptr;
+
+		// Particles emitted since the last update are merged into the order here.
+		if (depthSort->getLength() != activeCount)
+			depthSort->update(&particles, activeCount);
+
+		return depthSort->getOrder();
+	}
+
+	const int32_t NativeEmitter::writeInstances(ParticleInstance* const instanceArrPtr, const int32_t maxLength, const float textureWidth, const float textureHeight)
+	{
+		const int32_t* const order = getSortedOrder();
+		if (order != nullptr)
+			return ParticleInstances::writeIndexed(&particles, order, activeCount, textureWidth, textureHeight, instanceArrPtr, maxLength, colorFormat);
+
+		return ParticleInstances::writeAll(&particles, activeCount, textureWidth, textureHeight, instanceArrPtr, maxLength, colorFormat);
+	}
+
+	DepthSortMode::Mode NativeEmitter::getDepthSort()
+	{
+		return depthSort->getMode();
+	}
+
+	void NativeEmitter::setDepthSort(const DepthSortMode::Mode mode)
+	{
+		depthSort->setMode(mode);
+	}
+
+	const int32_t NativeEmitter::copyDrawOrder(int32_t* const indexArrPtr, const int32_t maxLength)
+	{
+		const int32_t count = activeCount < maxLength ? activeCount : maxLength;
+		if (count <= 0)
+			return 0;
+
+		const int32_t* const order = getSortedOrder();
+		for (int32_t i = 0; i < count; i++) {
+			indexArrPtr[i] = order != nullptr ? order[i] : i;
+		}
+		return count;
+	}
+
+	const int32_t NativeEmitter::cull(const ViewBounds& view, int32_t* const indexArrPtr, const int32_t maxLength)
+	{
+		const int32_t count = ParticleInstances::cull(&particles, activeCount, view, visibleMask, visibleIndices);
+		const int32_t copied = count < maxLength ? count : maxLength;
+		if (copied > 0)
+			memcpy(indexArrPtr, visibleIndices, (size_t)copied * sizeof(int32_t));
+
+		return copied;
+	}
+
+	const int32_t NativeEmitter::collectVisible(const ViewBounds& view)
+	{
+		int32_t count = ParticleInstances::cull(&particles, activeCount, view, visibleMask, visibleIndices);
+
+		// Sorted draws walk the depth order and keep the visible particles.
+		const int32_t* const order = getSortedOrder();
+		if (order != nullptr) {
+			count = 0;
+			for (int32_t i = 0; i < activeCount; i++) {
+				const int32_t index = order[i];
+				if (visibleMask[index >> 3] & (1 << (index & 7)))
+					visibleIndices[count++] = index;
+			}
+		}
+		return count;
+	}
+
+	const int32_t NativeEmitter::writeVisibleInstances(const ViewBounds& view, ParticleInstance* const instanceArrPtr, const int32_t maxLength, const float textureWidth, const float textureHeight)
+	{
+		const int32_t count = collectVisible(view);
+		return ParticleInstances::writeIndexed(&particles, visibleIndices, count, textureWidth, textureHeight, instanceArrPtr, maxLength, colorFormat);
+	}
+
+	FrameTable* NativeEmitter::getFrames()
+	{
+		return frames;
+	}
+
+	InstanceColor::Format NativeEmitter::getColorFormat()
+	{
+		return colorFormat;
+	}
+
+	void NativeEmitter::setColorFormat(const InstanceColor::Format format)
+	{
+		colorFormat = format;
+	}
+
+	const int32_t NativeEmitter::writeCompactInstances(CompactParticleInstance* const instanceArrPtr, const int32_t maxLength)
+	{
+		return ParticleInstances::writeCompact(&particles, getSortedOrder(), activeCount, *frames, instanceArrPtr, maxLength, colorFormat);
+	}
+
+	const int32_t NativeEmitter::writeVisibleCompactInstances(const ViewBounds& view, CompactParticleInstance* const instanceArrPtr, const int32_t maxLength)
+	{
+		const int32_t count = collectVisible(view);
+		return ParticleInstances::writeCompact(&particles, visibleIndices, count, *frames, instanceArrPtr, maxLength, colorFormat);
+	}
+
+	void NativeEmitter::clear()
+	{
+		// Ids are handed out lowest first.
+		activeCount = 0;
+		freeCount = capacity;
+		for (int32_t i = 0; i < capacity; i++) {
+			freeIds[i] = capacity - 1 - i;
+		}
+	}
+
+	NativeEmitter::~NativeEmitter()
+	{
+		delete module;
+		delete[] freeIds;
+		delete[] liveMask;
+		delete[] visibleMask;
+		delete[] visibleIndices;
+		delete depthSort;
+		delete frames;
+	}
+
+	#pragma region INTEROP METHODS.
+
+	LIB_API(NativeEmitter*) nativeEmitter_Create(const int32_t capacity)
+	{
+		return new NativeEmitter(capacity);
+	}
+
+	// Submodules are attached and initialized (with the emitter's capacity) through this module.
+	LIB_API(NativeModule*) nativeEmitter_GetModule(NativeEmitter* const emitterPtr)
+	{
+		return emitterPtr->getModule();
+	}
+
+	LIB_API(int32_t) nativeEmitter_GetCapacity(NativeEmitter* const emitterPtr)
+	{
+		return emitterPtr->getCapacity();
+	}
+
+	LIB_API(int32_t) nativeEmitter_GetActiveCount(NativeEmitter* const emitterPtr)
+	{
+		return emitterPtr->getActiveCount();
+	}
+
+	LIB_API(int32_t) nativeEmitter_Emit(NativeEmitter* const emitterPtr, const Particle* const particleArrPtr, const int32_t length)
+	{
+		return emitterPtr->emit(particleArrPtr, length);
+	}
+
+	LIB_API(void) nativeEmitter_OnUpdate(NativeEmitter* const emitterPtr, const float deltaTime)
+	{
+		emitterPtr->onUpdate(deltaTime);
+	}
+
+	LIB_API(int32_t) nativeEmitter_CopyParticles(NativeEmitter* const emitterPtr, Particle* const particleArrPtr, const int32_t maxLength)
+	{
+		return emitterPtr->copyTo(particleArrPtr, maxLength);
+	}
+
+	// Fills a caller-owned buffer with up to maxLength instance records, ready for upload. Returns the count.
+	LIB_API(int32_t) nativeEmitter_WriteInstances(NativeEmitter* const emitterPtr, ParticleInstance* const instanceArrPtr, const int32_t maxLength, const float textureWidth, const float textureHeight)
+	{
+		return emitterPtr->writeInstances(instanceArrPtr, maxLength, textureWidth, textureHeight);
+	}
+
+	// Indices into the emitter's live range of the particles overlapping the view. Returns the count.
+	LIB_API(int32_t) nativeEmitter_Cull(NativeEmitter* const emitterPtr, const ViewBounds view, int32_t* const indexArrPtr, const int32_t maxLength)
+	{
+		return emitterPtr->cull(view, indexArrPtr, maxLength);
+	}
+
+	// Like nativeEmitter_WriteInstances, skipping particles outside the view.
+	LIB_API(int32_t) nativeEmitter_WriteVisibleInstances(NativeEmitter* const emitterPtr, const ViewBounds view, ParticleInstance* const instanceArrPtr, const int32_t maxLength, const float textureWidth, const float textureHeight)
+	{
+		return emitterPtr->writeVisibleInstances(view, instanceArrPtr, maxLength, textureWidth, textureHeight);
+	}
+
+	// InstanceColor: 0 packed HSLA (converted in the shader), 1 RGBA8 converted here. Applies to all instance writes.
+	LIB_API(void) nativeEmitter_SetInstanceColorFormat(NativeEmitter* const emitterPtr, const int32_t format)
+	{
+		emitterPtr->setColorFormat((InstanceColor::Format)format);
+	}
+
+	LIB_API(int32_t) nativeEmitter_GetInstanceColorFormat(NativeEmitter* const emitterPtr)
+	{
+		return emitterPtr->getColorFormat();
+	}
+
+	// Frames for compact instances: a uniform sprite sheet, numbered row by row. With a texture animation
+	// module it must be the same sheet as the module's; see nativeEmitter_GetFrameMisses.
+	LIB_API(void) nativeEmitter_SetFrameGrid(NativeEmitter* const emitterPtr, const int32_t textureWidth, const int32_t textureHeight, const int32_t rows, const int32_t columns)
+	{
+		emitterPtr->getFrames()->setGrid(textureWidth, textureHeight, rows, columns);
+	}
+
+	// Frames for compact instances from arbitrary source rectangles, e.g. an atlas.
+	LIB_API(void) nativeEmitter_SetFrames(NativeEmitter* const emitterPtr, const Int4* const rectArrPtr, const int32_t length, const int32_t textureWidth, const int32_t textureHeight)
+	{
+		emitterPtr->getFrames()->setFrames(rectArrPtr, length, textureWidth, textureHeight);
+	}
+
+	// The frame UV table the shader indexes with CompactParticleInstance.frame. Returns the frame count.
+	LIB_API(int32_t) nativeEmitter_GetFrameUVs(NativeEmitter* const emitterPtr, FrameUV* const uvArrPtr, const int32_t maxLength)
+	{
+		FrameTable* const frames = emitterPtr->getFrames();
+		const int32_t count = frames->getFrameCount() < maxLength ? frames->getFrameCount() : maxLength;
+		if (count <= 0)
+			return 0;
+
+		memcpy(uvArrPtr, frames->getUVs(), (size_t)count * sizeof(FrameUV));
+		return count;
+	}
+
+	// Particles the last compact write couldn't find in the frame table. They're drawn as frame 0.
+	LIB_API(int32_t) nativeEmitter_GetFrameMisses(NativeEmitter* const emitterPtr)
+	{
+		return emitterPtr->getFrames()->getMissCount();
+	}
+
+	// Like nativeEmitter_WriteInstances with 20 byte records instead of 40.
+	LIB_API(int32_t) nativeEmitter_WriteCompactInstances(NativeEmitter* const emitterPtr, CompactParticleInstance* const instanceArrPtr, const int32_t maxLength)
+	{
+		return emitterPtr->writeCompactInstances(instanceArrPtr, maxLength);
+	}
+
+	LIB_API(int32_t) nativeEmitter_WriteVisibleCompactInstances(NativeEmitter* const emitterPtr, const ViewBounds view, CompactParticleInstance* const instanceArrPtr, const int32_t maxLength)
+	{
+		return emitterPtr->writeVisibleCompactInstances(view, instanceArrPtr, maxLength);
+	}
+
+	// DepthSortMode: 0 none, 1 back to front, 2 front to back (by layerDepth). Sorting runs in the update.
+	LIB_API(void) nativeEmitter_SetDepthSort(NativeEmitter* const emitterPtr, const int32_t mode)
+	{
+		emitterPtr->setDepthSort((DepthSortMode::Mode)mode);
+	}
+
+	LIB_API(int32_t) nativeEmitter_GetDepthSort(NativeEmitter* const emitterPtr)
+	{
+		return emitterPtr->getDepthSort();
+	}
+
+	// Particle indices in draw order (identity when unsorted). Returns the count.
+	LIB_API(int32_t) nativeEmitter_GetDrawOrder(NativeEmitter* const emitterPtr, int32_t* const indexArrPtr, const int32_t maxLength)
+	{
+		return emitterPtr->copyDrawOrder(indexArrPtr, maxLength);
+	}
+
+	// Seeds the emitter's activation randomness. Same seed and same emits give the same particles.
+	LIB_API(void) nativeEmitter_SetSeed(NativeEmitter* const emitterPtr, const uint64_t seed)
+	{
+		emitterPtr->getModule()->setSeed(seed);
+	}
+
+	LIB_API(void) nativeEmitter_Clear(NativeEmitter* const emitterPtr)
+	{
+		emitterPtr->clear();
+	}
+
+	LIB_API(void) nativeEmitter_Delete(NativeEmitter* const emitterPtr)
+	{
+		delete emitterPtr;
+	}
+
+	#pragma endregion
+
+}
\ No newline at end of file
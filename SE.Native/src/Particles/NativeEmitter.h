@@ -0,0 +1,68 @@
+#pragma once
+
+#ifndef NATIVEEMITTER_H
+#define NATIVEEMITTER_H
+
+#include "src/SE.Native.h"
+#include "Particle.h"
+#include "ParticleBuffer.h"
+#include "NativeModule.h"
+#include "ParticleInstances.h"
+#include "DepthSort.h"
+
+namespace Particles {
+
+	// Natively owned particle simulation. Live particles are kept dense and in emission order in
+	// [0, activeCount) of the buffer, and ids of retired particles go back to a free list for reuse.
+	// With a depth sort mode set, the update also sorts the draw order, and instance writes follow it. One update call
+	// integrates, ages, retires and then runs the attached submodules.
+	class NativeEmitter {
+	private:
+		ParticleBuffer particles;
+		NativeModule* module;
+		int32_t capacity;
+		int32_t activeCount = 0;
+		int32_t* freeIds = nullptr;
+		int32_t freeCount = 0;
+		uint8_t* liveMask = nullptr;
+		uint8_t* visibleMask = nullptr;
+		int32_t* visibleIndices = nullptr;
+		DepthSort* depthSort;
+		FrameTable* frames;
+		InstanceColor::Format colorFormat = InstanceColor::Hsla;
+
+		void integrate(const float deltaTime);
+		void retireDead();
+		const int32_t* getSortedOrder();
+		const int32_t collectVisible(const ViewBounds& view);
+
+	public:
+		NativeEmitter(const int32_t capacity);
+
+		NativeModule* getModule();
+		const int32_t getCapacity();
+		const int32_t getActiveCount();
+		ParticleBuffer* getParticles();
+
+		const int32_t emit(const Particle* const particleArrPtr, const int32_t length);
+		void onUpdate(const float deltaTime);
+		const int32_t copyTo(Particle* const particleArrPtr, const int32_t maxLength);
+		const int32_t writeInstances(ParticleInstance* const instanceArrPtr, const int32_t maxLength, const float textureWidth, const float textureHeight);
+		const int32_t cull(const ViewBounds& view, int32_t* const indexArrPtr, const int32_t maxLength);
+		DepthSortMode::Mode getDepthSort();
+		void setDepthSort(const DepthSortMode::Mode mode);
+		const int32_t copyDrawOrder(int32_t* const indexArrPtr, const int32_t maxLength);
+		const int32_t writeVisibleInstances(const ViewBounds& view, ParticleInstance* const instanceArrPtr, const int32_t maxLength, const float textureWidth, const float textureHeight);
+		FrameTable* getFrames();
+		InstanceColor::Format getColorFormat();
+		void setColorFormat(const InstanceColor::Format format);
+		const int32_t writeCompactInstances(CompactParticleInstance* const instanceArrPtr, const int32_t maxLength);
+		const int32_t writeVisibleCompactInstances(const ViewBounds& view, CompactParticleInstance* const instanceArrPtr, const int32_t maxLength);
+		void clear();
+
+		~NativeEmitter();
+	};
+
+}
+
+#endif
\ No newline at end of file
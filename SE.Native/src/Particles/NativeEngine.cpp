@@ -0,0 +1,109 @@
+#include "NativeEngine.h"
+#include "NativeModule.h"
+#include "NativeEmitter.h"
+
+namespace Particles {
+
+	const int32_t NativeEngine::getThreadCount()
+	{
+		return Utility::ThreadPool::get().getThreadCount();
+	}
+
+	void NativeEngine::setThreadCount(const int32_t count)
+	{
+		Utility::ThreadPool::get().setThreadCount(count);
+	}
+
+	const int32_t NativeEngine::getMinGrainSize()
+	{
+		return Utility::ThreadPool::get().getMinGrainSize();
+	}
+
+	void NativeEngine::setMinGrainSize(const int32_t size)
+	{
+		Utility::ThreadPool::get().setMinGrainSize(size);
+	}
+
+	const int32_t NativeEngine::getSimdPath()
+	{
+		return (int32_t)Utility::SimdKernels::getPath();
+	}
+
+	void NativeEngine::setSimdPath(const int32_t path)
+	{
+		Utility::SimdKernels::setPath((Utility::SimdPath::Path)path);
+	}
+
+	void NativeEngine::updateBatch(const EmitterUpdateDesc* const descs, const int32_t count, const float deltaTime)
+	{
+		// Emitters are independent, so they are spread over the pool. Large emitters still split
+		// their own particle ranges further from inside their task.
+		Utility::ThreadPool::get().parallelForEach(0, count, [descs, deltaTime](const int32_t start, const int32_t end) {
+			for (int32_t i = start; i < end; i++) {
+				const EmitterUpdateDesc& desc = descs[i];
+				if (desc.activatedLength > 0)
+					desc.module->onParticlesActivated(desc.activatedIndices, desc.particles, desc.activatedLength);
+
+				desc.module->onUpdate(deltaTime, desc.particles, desc.length);
+			}
+		});
+	}
+
+	void NativeEngine::updateEmitters(NativeEmitter* const* const emitters, const int32_t count, const float deltaTime)
+	{
+		Utility::ThreadPool::get().parallelForEach(0, count, [emitters, deltaTime](const int32_t start, const int32_t end) {
+			for (int32_t i = start; i < end; i++) {
+				emitters[i]->onUpdate(deltaTime);
+			}
+		});
+	}
+
+	#pragma region INTEROP METHODS.
+
+	LIB_API(int32_t) nativeEngine_GetThreadCount()
+	{
+		return NativeEngine::getThreadCount();
+	}
+
+	// Values <= 0 select the hardware thread count. Must not be called while particles are updating.
+	LIB_API(void) nativeEngine_SetThreadCount(const int32_t count)
+	{
+		NativeEngine::setThreadCount(count);
+	}
+
+	LIB_API(int32_t) nativeEngine_GetMinGrainSize()
+	{
+		return NativeEngine::getMinGrainSize();
+	}
+
+	LIB_API(void) nativeEngine_SetMinGrainSize(const int32_t size)
+	{
+		NativeEngine::setMinGrainSize(size);
+	}
+
+	// Kernel variant in use: 0 = scalar, 1 = SSE2, 2 = AVX2, 3 = AVX-512.
+	LIB_API(int32_t) nativeEngine_GetSimdPath()
+	{
+		return NativeEngine::getSimdPath();
+	}
+
+	// Forces a lower variant, clamped to what the CPU supports. Must not be called while particles are updating.
+	LIB_API(void) nativeEngine_SetSimdPath(const int32_t path)
+	{
+		NativeEngine::setSimdPath(path);
+	}
+
+	// Updates many managed-storage emitters with one transition. Each module must appear at most once.
+	LIB_API(void) nativeEngine_UpdateBatch(const EmitterUpdateDesc* const descs, const int32_t count, const float deltaTime)
+	{
+		NativeEngine::updateBatch(descs, count, deltaTime);
+	}
+
+	LIB_API(void) nativeEngine_UpdateEmitters(NativeEmitter* const* const emitters, const int32_t count, const float deltaTime)
+	{
+		NativeEngine::updateEmitters(emitters, count, deltaTime);
+	}
+
+	#pragma endregion
+
+}
\ No newline at end of file
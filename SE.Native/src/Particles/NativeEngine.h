@@ -0,0 +1,42 @@
+#pragma once
+
+#ifndef NATIVEENGINE_H
+#define NATIVEENGINE_H
+
+#include "src/SE.Native.h"
+#include "src/Utility/ThreadPool.h"
+#include "src/Utility/SimdKernels.h"
+
+namespace Particles {
+	class NativeModule;
+	class NativeEmitter;
+	struct Particle;
+
+	// One emitter's frame of work when its particles live in managed memory. Activation (if any)
+	// runs before the update, matching separate OnParticlesActivated/OnUpdate calls.
+	struct EmitterUpdateDesc {
+	public:
+		NativeModule* module;
+		Particle* particles;
+		int32_t length;
+		const int32_t* activatedIndices;
+		int32_t activatedLength;
+	};
+
+	// Engine-wide settings shared by every native module, and batched updates across emitters.
+	class NativeEngine {
+	public:
+		static const int32_t getThreadCount();
+		static void setThreadCount(const int32_t count);
+		static const int32_t getMinGrainSize();
+		static void setMinGrainSize(const int32_t size);
+		static const int32_t getSimdPath();
+		static void setSimdPath(const int32_t path);
+
+		static void updateBatch(const EmitterUpdateDesc* const descs, const int32_t count, const float deltaTime);
+		static void updateEmitters(NativeEmitter* const* const emitters, const int32_t count, const float deltaTime);
+	};
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,270 @@
+#include "NativeFlowFieldModule.h"
+#include "ParticleMath.h"
+#include "Particle.h"
+#include "src/Utility.h"
+#include <stdexcept>
+#include <math.h>
+
+namespace Particles {
+
+	NativeFlowFieldModule::NativeFlowFieldModule() : NativeSubmodule() { }
+
+	bool NativeFlowFieldModule::hasField()
+	{
+		return columns > 0 && rows > 0;
+	}
+
+	void NativeFlowFieldModule::onInitialize(const int32_t particleArrayLength)
+	{
+		particlesLength = particleArrayLength;
+		isInitialized = true;
+	}
+
+	void NativeFlowFieldModule::onFrameBegin(const float deltaTime, ParticleBuffer* const buffer, const int32_t length)
+	{
+		if (!hasField())
+			return;
+
+		// A repeating field is periodic, so the offset is kept within one period to hold its precision.
+		scrollOffset.x += scroll.x * deltaTime;
+		scrollOffset.y += scroll.y * deltaTime;
+		if (repeat) {
+			const float width = columns * cellSize;
+			const float height = rows * cellSize;
+			scrollOffset.x -= floorf(scrollOffset.x / width) * width;
+			scrollOffset.y -= floorf(scrollOffset.y / height) * height;
+		}
+	}
+
+	void NativeFlowFieldModule::onUpdate(const float deltaTime, ParticleBuffer* const buffer, const int32_t start, const int32_t end)
+	{
+		if (!hasField())
+			return;
+
+		if (mode == FlowMode::Follow) {
+			if (repeat) advect<true, true>(deltaTime, buffer, start, end);
+			else advect<false, true>(deltaTime, buffer, start, end);
+		} else {
+			if (repeat) advect<true, false>(deltaTime, buffer, start, end);
+			else advect<false, false>(deltaTime, buffer, start, end);
+		}
+	}
+
+	template<bool REPEAT, bool FOLLOW>
+	void NativeFlowFieldModule::advect(const float deltaTime, ParticleBuffer* const buffer, const int32_t start, const int32_t end)
+	{
+		const float* const __restrict vectorX = fieldX.data();
+		const float* const __restrict vectorY = fieldY.data();
+		const float* const __restrict positionX = buffer->positionX;
+		const float* const __restrict positionY = buffer->positionY;
+		const float* const __restrict mass = buffer->mass;
+		float* const __restrict directionX = buffer->directionX;
+		float* const __restrict directionY = buffer->directionY;
+		float* const __restrict speed = buffer->speed;
+		const float inverseCellSize = 1.0f / cellSize;
+		const float originX = origin.x + scrollOffset.x;
+		const float originY = origin.y + scrollOffset.y;
+		const int32_t gridColumns = columns;
+		const float columnCount = (float)columns;
+		const float rowCount = (float)rows;
+		const float lastColumn = (float)(columns - 1);
+		const float lastRow = (float)(rows - 1);
+
+		// Follow moves velocity a fraction of the way to the field, the exact fraction for a constant
+		// rate over the step.
+		const float fieldStrength = strength;
+		const float followFraction = 1.0f - expf(-rate * deltaTime);
+
+		#pragma omp simd
+		for (int32_t i = start; i < end; i++) {
+			// Grid coordinates relative to cell centers. A repeating field wraps them into the grid, so the
+			// last and first cells blend. Otherwise they're clamped, and the field is 0 outside.
+			const float gridX = ((positionX[i] - originX) * inverseCellSize) - 0.5f;
+			const float gridY = ((positionY[i] - originY) * inverseCellSize) - 0.5f;
+			float sampleX, sampleY, inGrid;
+			if (REPEAT) {
+				const float periodsX = gridX / columnCount;
+				const float periodsY = gridY / rowCount;
+				const float truncatedX = (float)(int32_t)periodsX;
+				const float truncatedY = (float)(int32_t)periodsY;
+				sampleX = gridX - ((truncatedX - (truncatedX > periodsX ? 1.0f : 0.0f)) * columnCount);
+				sampleY = gridY - ((truncatedY - (truncatedY > periodsY ? 1.0f : 0.0f)) * rowCount);
+				inGrid = 1.0f;
+			} else {
+				sampleX = gridX < 0.0f ? 0.0f : (gridX > lastColumn ? lastColumn : gridX);
+				sampleY = gridY < 0.0f ? 0.0f : (gridY > lastRow ? lastRow : gridY);
+				inGrid = (gridX >= -0.5f && gridX <= lastColumn + 0.5f && gridY >= -0.5f && gridY <= lastRow + 0.5f) ? 1.0f : 0.0f;
+			}
+
+			// Rounding can land a wrapped coordinate on the period itself, which is the first cell again.
+			const int32_t rawColumn = (int32_t)sampleX;
+			const int32_t rawRow = (int32_t)sampleY;
+			const int32_t column = (float)rawColumn > lastColumn ? rawColumn - gridColumns : rawColumn;
+			const int32_t row = (float)rawRow > lastRow ? 0 : rawRow;
+			const int32_t nextColumn = (float)column < lastColumn ? column + 1 : (REPEAT ? 0 : column);
+			const int32_t nextRow = (float)row < lastRow ? row + 1 : (REPEAT ? 0 : row);
+			const float weightX = sampleX - (float)rawColumn;
+			const float weightY = sampleY - (float)rawRow;
+
+			const int32_t topLeft = (row * gridColumns) + column;
+			const int32_t topRight = (row * gridColumns) + nextColumn;
+			const int32_t bottomLeft = (nextRow * gridColumns) + column;
+			const int32_t bottomRight = (nextRow * gridColumns) + nextColumn;
+			const float topX = vectorX[topLeft] + ((vectorX[topRight] - vectorX[topLeft]) * weightX);
+			const float topY = vectorY[topLeft] + ((vectorY[topRight] - vectorY[topLeft]) * weightX);
+			const float bottomX = vectorX[bottomLeft] + ((vectorX[bottomRight] - vectorX[bottomLeft]) * weightX);
+			const float bottomY = vectorY[bottomLeft] + ((vectorY[bottomRight] - vectorY[bottomLeft]) * weightX);
+			const float flowX = (topX + ((bottomX - topX) * weightY)) * inGrid * fieldStrength;
+			const float flowY = (topY + ((bottomY - topY) * weightY)) * inGrid * fieldStrength;
+
+			const float particleMass = mass[i];
+			const float oldVelocityX = directionX[i] * speed[i];
+			const float oldVelocityY = directionY[i] * speed[i];
+			float velocityX, velocityY;
+			if (FOLLOW) {
+				// Outside a field that ends, velocity is left alone rather than eased toward 0.
+				velocityX = oldVelocityX + ((flowX - oldVelocityX) * followFraction * inGrid);
+				velocityY = oldVelocityY + ((flowY - oldVelocityY) * followFraction * inGrid);
+			} else {
+				const float inverseMass = 1.0f / (particleMass > 0.0f ? particleMass : 1.0f);
+				velocityX = oldVelocityX + (flowX * deltaTime * inverseMass);
+				velocityY = oldVelocityY + (flowY * deltaTime * inverseMass);
+			}
+			ParticleMath::setVelocity(velocityX, velocityY, &directionX[i], &directionY[i], &speed[i]);
+		}
+	}
+
+	const uint32_t NativeFlowFieldModule::getReadStreams()
+	{
+		return ParticleStream::Position | ParticleStream::Mass | ParticleStream::Direction | ParticleStream::Speed;
+	}
+
+	const uint32_t NativeFlowFieldModule::getWriteStreams()
+	{
+		if (!hasField())
+			return ParticleStream::None;
+
+		return ParticleStream::Direction | ParticleStream::Speed;
+	}
+
+	const bool NativeFlowFieldModule::isValid()
+	{
+		return false; // ???
+	}
+
+	void NativeFlowFieldModule::setGridBounds(const int32_t columns, const int32_t rows, const Vector2 origin, const float cellSize)
+	{
+		if (columns <= 0 || rows <= 0)
+			throw std::invalid_argument("Field must have at least one cell!");
+		if ((int64_t)columns * rows > INT32_MAX)
+			throw std::invalid_argument("Field is too large!");
+		if (!(cellSize > 0.0f))
+			throw std::invalid_argument("Cell size must be positive!");
+
+		this->columns = columns;
+		this->rows = rows;
+		this->origin = origin;
+		this->cellSize = cellSize;
+	}
+
+	void NativeFlowFieldModule::setField(const Vector2* const vectors, const int32_t columns, const int32_t rows, const Vector2 origin, const float cellSize)
+	{
+		setGridBounds(columns, rows, origin, cellSize);
+
+		// Stored as separate x and y planes, so sampling gathers plain floats.
+		const int32_t cellCount = columns * rows;
+		fieldX.resize(cellCount);
+		fieldY.resize(cellCount);
+		for (int32_t i = 0; i < cellCount; i++) {
+			fieldX[i] = vectors[i].x;
+			fieldY[i] = vectors[i].y;
+		}
+	}
+
+	void NativeFlowFieldModule::setFieldRgba(const uint8_t* const pixels, const int32_t columns, const int32_t rows, const Vector2 origin, const float cellSize)
+	{
+		setGridBounds(columns, rows, origin, cellSize);
+
+		const int32_t cellCount = columns * rows;
+		fieldX.resize(cellCount);
+		fieldY.resize(cellCount);
+		for (int32_t i = 0; i < cellCount; i++) {
+			fieldX[i] = ((pixels[i * 4] / 255.0f) * 2.0f) - 1.0f;
+			fieldY[i] = ((pixels[(i * 4) + 1] / 255.0f) * 2.0f) - 1.0f;
+		}
+	}
+
+	void NativeFlowFieldModule::clearField()
+	{
+		columns = 0;
+		rows = 0;
+		std::vector<float>().swap(fieldX);
+		std::vector<float>().swap(fieldY);
+	}
+
+	void NativeFlowFieldModule::setRepeat(const bool val)
+	{
+		repeat = val;
+	}
+
+	void NativeFlowFieldModule::setScroll(const Vector2 velocity)
+	{
+		scroll = velocity;
+	}
+
+	void NativeFlowFieldModule::setForce(const float strength)
+	{
+		mode = FlowMode::Force;
+		this->strength = strength;
+	}
+
+	void NativeFlowFieldModule::setFollow(const float strength, const float rate)
+	{
+		mode = FlowMode::Follow;
+		this->strength = strength;
+		this->rate = rate > 0.0f ? rate : 0.0f;
+	}
+
+	NativeFlowFieldModule::~NativeFlowFieldModule() { }
+
+	LIB_API(NativeFlowFieldModule*) nativeModule_FlowFieldModule_Ctor()
+	{
+		return new NativeFlowFieldModule();
+	}
+
+	LIB_API(void) nativeModule_FlowFieldModule_SetField(NativeFlowFieldModule* const modulePtr, const Vector2* const vectorArrPtr, const int32_t columns, const int32_t rows, const Vector2 origin, const float cellSize)
+	{
+		modulePtr->setField(vectorArrPtr, columns, rows, origin, cellSize);
+	}
+
+	LIB_API(void) nativeModule_FlowFieldModule_SetFieldRgba(NativeFlowFieldModule* const modulePtr, const uint8_t* const pixelArrPtr, const int32_t columns, const int32_t rows, const Vector2 origin, const float cellSize)
+	{
+		modulePtr->setFieldRgba(pixelArrPtr, columns, rows, origin, cellSize);
+	}
+
+	LIB_API(void) nativeModule_FlowFieldModule_ClearField(NativeFlowFieldModule* const modulePtr)
+	{
+		modulePtr->clearField();
+	}
+
+	LIB_API(void) nativeModule_FlowFieldModule_SetRepeat(NativeFlowFieldModule* const modulePtr, const bool val)
+	{
+		modulePtr->setRepeat(val);
+	}
+
+	LIB_API(void) nativeModule_FlowFieldModule_SetScroll(NativeFlowFieldModule* const modulePtr, const Vector2 velocity)
+	{
+		modulePtr->setScroll(velocity);
+	}
+
+	LIB_API(void) nativeModule_FlowFieldModule_SetForce(NativeFlowFieldModule* const modulePtr, const float strength)
+	{
+		modulePtr->setForce(strength);
+	}
+
+	LIB_API(void) nativeModule_FlowFieldModule_SetFollow(NativeFlowFieldModule* const modulePtr, const float strength, const float rate)
+	{
+		modulePtr->setFollow(strength, rate);
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,72 @@
+#pragma once
+
+#ifndef NATIVEFLOWFIELDMODULE_H
+#define NATIVEFLOWFIELDMODULE_H
+
+#include "src/SE.Native.h"
+#include "Particle.h"
+#include "NativeSubmodule.h"
+#include "src/Utility.h"
+#include <vector>
+
+namespace Particles {
+
+	namespace FlowMode {
+		// Force adds strength * field as an acceleration. Follow eases velocity toward strength * field,
+		// closing the gap at 'rate' per second, the way smoke is carried by the air around it.
+		enum Mode : int32_t { Force, Follow };
+	}
+
+	// Moves particles through a grid of 2D vectors sampled bilinearly between cell centers. The field
+	// can scroll, and either repeat or end at its edges, where it's 0 outside.
+	class NativeFlowFieldModule final : NativeSubmodule {
+	private:
+		int particlesLength;
+		std::vector<float> fieldX;
+		std::vector<float> fieldY;
+		int32_t columns = 0;
+		int32_t rows = 0;
+		Vector2 origin = Vector2(0.0f, 0.0f);
+		float cellSize = 1.0f;
+		bool repeat = false;
+
+		// Offset of the field from its origin, advanced once per frame by the scroll velocity.
+		Vector2 scroll = Vector2(0.0f, 0.0f);
+		Vector2 scrollOffset = Vector2(0.0f, 0.0f);
+
+		FlowMode::Mode mode = FlowMode::Force;
+		float strength = 1.0f;
+		float rate = 0.0f;
+
+		bool hasField();
+		template<bool REPEAT, bool FOLLOW>
+		void advect(const float deltaTime, ParticleBuffer* const buffer, const int32_t start, const int32_t end);
+		void setGridBounds(const int32_t columns, const int32_t rows, const Vector2 origin, const float cellSize);
+
+	public:
+		NativeFlowFieldModule();
+
+		void onInitialize(const int32_t particleArrayLength) override;
+		void onFrameBegin(const float deltaTime, ParticleBuffer* const buffer, const int32_t length) override;
+		void onUpdate(const float deltaTime, ParticleBuffer* const buffer, const int32_t start, const int32_t end) override;
+		const uint32_t getReadStreams() override;
+		const uint32_t getWriteStreams() override;
+		const bool isValid() override;
+
+		// Cell (column, row) is vectors[(row * columns) + column]. Origin is the top left corner of the grid.
+		void setField(const Vector2* const vectors, const int32_t columns, const int32_t rows, const Vector2 origin, const float cellSize);
+
+		// A flow map texture, 4 bytes per pixel with red and green mapping 0..255 to -1..1 along x and y.
+		void setFieldRgba(const uint8_t* const pixels, const int32_t columns, const int32_t rows, const Vector2 origin, const float cellSize);
+		void clearField();
+
+		void setRepeat(const bool val);
+		void setScroll(const Vector2 velocity);
+		void setForce(const float strength);
+		void setFollow(const float strength, const float rate);
+
+		~NativeFlowFieldModule() override;
+	};
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,179 @@
+#include "NativeForcesModule.h"
+#include "ParticleMath.h"
+#include "Particle.h"
+#include "src/Utility.h"
+#include <math.h>
+
+namespace Particles {
+
+	namespace {
+		// Per-particle curve multipliers for a block, or 1 without a curve.
+		void evaluateScale(Curve* const curve, const float* const life, float* const out, const int32_t count)
+		{
+			if (curve != nullptr) {
+				curve->EvaluateBakedBatch(life, out, (size_t)count);
+				return;
+			}
+			for (int32_t i = 0; i < count; i++) {
+				out[i] = 1.0f;
+			}
+		}
+	}
+
+	NativeForcesModule::NativeForcesModule() : NativeSubmodule() { }
+
+	bool NativeForcesModule::hasForces()
+	{
+		return gravity.x != 0.0f || gravity.y != 0.0f || wind.x != 0.0f || wind.y != 0.0f
+			|| linearDrag != 0.0f || quadraticDrag != 0.0f;
+	}
+
+	void NativeForcesModule::replaceCurve(Curve*& target, Curve* const curve)
+	{
+		if (target != nullptr)
+			delete target;
+
+		target = curve;
+		if (curve != nullptr)
+			curve->EnsureBaked();
+	}
+
+	void NativeForcesModule::onInitialize(const int32_t particleArrayLength)
+	{
+		particlesLength = particleArrayLength;
+		isInitialized = true;
+	}
+
+	void NativeForcesModule::onUpdate(const float deltaTime, ParticleBuffer* const buffer, const int32_t start, const int32_t end)
+	{
+		if (!hasForces())
+			return;
+
+		const float* const __restrict life = buffer->life;
+		const float* const __restrict mass = buffer->mass;
+		float* const __restrict directionX = buffer->directionX;
+		float* const __restrict directionY = buffer->directionY;
+		float* const __restrict speed = buffer->speed;
+		const float gravityX = gravity.x * deltaTime, gravityY = gravity.y * deltaTime;
+		const float windX = wind.x * deltaTime, windY = wind.y * deltaTime;
+		const float linear = linearDrag * deltaTime, quadratic = quadraticDrag * deltaTime;
+
+		// Curve multipliers are evaluated a block at a time, then one vectorized pass applies the forces.
+		const int32_t blockSize = 256;
+		float gravityScale[blockSize], windScale[blockSize], dragScale[blockSize];
+		for (int32_t blockStart = start; blockStart < end; blockStart += blockSize) {
+			const int32_t count = (end - blockStart) < blockSize ? (end - blockStart) : blockSize;
+			evaluateScale(gravityCurve, &life[blockStart], gravityScale, count);
+			evaluateScale(windCurve, &life[blockStart], windScale, count);
+			evaluateScale(dragCurve, &life[blockStart], dragScale, count);
+
+			#pragma omp simd
+			for (int32_t j = 0; j < count; j++) {
+				const int32_t i = blockStart + j;
+				const float particleMass = mass[i];
+				const float inverseMass = 1.0f / (particleMass > 0.0f ? particleMass : 1.0f);
+				const float velocityX = (directionX[i] * speed[i]) + (gravityX * gravityScale[j]) + (windX * windScale[j] * inverseMass);
+				const float velocityY = (directionY[i] * speed[i]) + (gravityY * gravityScale[j]) + (windY * windScale[j] * inverseMass);
+				ParticleMath::setVelocity(velocityX, velocityY, &directionX[i], &directionY[i], &speed[i]);
+
+				// Drag is integrated implicitly, so large coefficients or time steps slow particles down
+				// without ever reversing them.
+				const float length = speed[i];
+				const float damping = 1.0f / (1.0f + ((linear + (quadratic * length)) * dragScale[j] * inverseMass));
+				speed[i] = length * damping;
+			}
+		}
+	}
+
+	const uint32_t NativeForcesModule::getReadStreams()
+	{
+		return ParticleStream::Life | ParticleStream::Mass | ParticleStream::Direction | ParticleStream::Speed;
+	}
+
+	const uint32_t NativeForcesModule::getWriteStreams()
+	{
+		if (!hasForces())
+			return ParticleStream::None;
+
+		return ParticleStream::Direction | ParticleStream::Speed;
+	}
+
+	const bool NativeForcesModule::isValid()
+	{
+		return false; // ???
+	}
+
+	void NativeForcesModule::setGravity(const Vector2 gravity)
+	{
+		this->gravity = gravity;
+	}
+
+	void NativeForcesModule::setWind(const Vector2 wind)
+	{
+		this->wind = wind;
+	}
+
+	void NativeForcesModule::setDrag(const float linear, const float quadratic)
+	{
+		linearDrag = linear > 0.0f ? linear : 0.0f;
+		quadraticDrag = quadratic > 0.0f ? quadratic : 0.0f;
+	}
+
+	void NativeForcesModule::setGravityCurve(Curve* const curve)
+	{
+		replaceCurve(gravityCurve, curve);
+	}
+
+	void NativeForcesModule::setWindCurve(Curve* const curve)
+	{
+		replaceCurve(windCurve, curve);
+	}
+
+	void NativeForcesModule::setDragCurve(Curve* const curve)
+	{
+		replaceCurve(dragCurve, curve);
+	}
+
+	NativeForcesModule::~NativeForcesModule()
+	{
+		delete gravityCurve;
+		delete windCurve;
+		delete dragCurve;
+	}
+
+	LIB_API(NativeForcesModule*) nativeModule_ForcesModule_Ctor()
+	{
+		return new NativeForcesModule();
+	}
+
+	LIB_API(void) nativeModule_ForcesModule_SetGravity(NativeForcesModule* const modulePtr, const Vector2 gravity)
+	{
+		modulePtr->setGravity(gravity);
+	}
+
+	LIB_API(void) nativeModule_ForcesModule_SetWind(NativeForcesModule* const modulePtr, const Vector2 wind)
+	{
+		modulePtr->setWind(wind);
+	}
+
+	LIB_API(void) nativeModule_ForcesModule_SetDrag(NativeForcesModule* const modulePtr, const float linear, const float quadratic)
+	{
+		modulePtr->setDrag(linear, quadratic);
+	}
+
+	LIB_API(void) nativeModule_ForcesModule_SetGravityCurve(NativeForcesModule* const modulePtr, Curve* const curvePtr)
+	{
+		modulePtr->setGravityCurve(curvePtr);
+	}
+
+	LIB_API(void) nativeModule_ForcesModule_SetWindCurve(NativeForcesModule* const modulePtr, Curve* const curvePtr)
+	{
+		modulePtr->setWindCurve(curvePtr);
+	}
+
+	LIB_API(void) nativeModule_ForcesModule_SetDragCurve(NativeForcesModule* const modulePtr, Curve* const curvePtr)
+	{
+		modulePtr->setDragCurve(curvePtr);
+	}
+
+}
\ No newline at end of file
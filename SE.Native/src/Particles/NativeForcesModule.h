@@ -0,0 +1,52 @@
+#pragma once
+
+#ifndef NATIVEFORCESSUBMODULE_H
+#define NATIVEFORCESSUBMODULE_H
+
+#include "src/SE.Native.h"
+#include "Particle.h"
+#include "NativeSubmodule.h"
+#include "src/Utility.h"
+
+namespace Particles {
+
+	// Gravity, wind and drag. Velocity is direction * speed; forces change it and the result is split
+	// back into a unit direction and a speed. Gravity is an acceleration, wind and drag are forces
+	// (divided by mass, where mass <= 0 counts as 1). Each term can be scaled over life by a curve.
+	class NativeForcesModule final : NativeSubmodule {
+	private:
+		int particlesLength;
+		Vector2 gravity = Vector2(0.0f, 0.0f);
+		Vector2 wind = Vector2(0.0f, 0.0f);
+		float linearDrag = 0.0f;
+		float quadraticDrag = 0.0f;
+		Curve* gravityCurve = nullptr;
+		Curve* windCurve = nullptr;
+		Curve* dragCurve = nullptr;
+
+		bool hasForces();
+		void replaceCurve(Curve*& target, Curve* const curve);
+
+	public:
+		NativeForcesModule();
+
+		void onInitialize(const int32_t particleArrayLength) override;
+		void onUpdate(const float deltaTime, ParticleBuffer* const buffer, const int32_t start, const int32_t end) override;
+		const uint32_t getReadStreams() override;
+		const uint32_t getWriteStreams() override;
+		const bool isValid() override;
+
+		void setGravity(const Vector2 gravity);
+		void setWind(const Vector2 wind);
+		void setDrag(const float linear, const float quadratic);
+
+		// Multipliers over normalized life. nullptr goes back to a constant 1.
+		void setGravityCurve(Curve* const curve);
+		void setWindCurve(Curve* const curve);
+		void setDragCurve(Curve* const curve);
+
+		~NativeForcesModule() override;
+	};
+}
+
+#endif
\ No newline at end of file
@@ -1,7 +1,7 @@
 #include "NativeHueModule.h"
 #include "ParticleMath.h"
 #include "Particle.h"
-#include "src/Utility/Random.h"
+#include "ColorKernels.h"
 
 namespace Particles {
 
@@ -17,57 +17,71 @@ namespace Particles {
 		if (!isRandom() || !isInitialized)
 			return;
 
-		delete[] randEndHues;
-		randEndHues = new float[particlesLength];
+		randomHandle = arena->acquire(ParticleAttribute::Random3);
 	}
 
 	void NativeHueModule::onInitialize(const int32_t particleArrayLength)
 	{
 		particlesLength = particleArrayLength;
-		startHuesArr = new float[particlesLength];
+		startColorsHandle = arena->acquire(ParticleAttribute::StartColor);
 		isInitialized = true;
 
 		regenerateRandom();
 	}
 
-	void NativeHueModule::onParticlesActivated(const int32_t* const particleIndexArr, Particle* const particlesArrPtr, const int32_t length)
+	void NativeHueModule::onUpdate(const float deltaTime, ParticleBuffer* const buffer, const int32_t start, const int32_t end)
 	{
-		for (int32_t i = 0; i < length; i++) {
-			int32_t pIndex = particleIndexArr[i];
-			Particle* particle = &particlesArrPtr[pIndex];
-			startHuesArr[particle->id] = particle->color.getHue();
-			if (!isRandom())
-				continue;
+		const ParticleColor* const startColors = arena->get<ParticleColor>(startColorsHandle);
+		const float* const random = arena->get<float>(randomHandle);
+		if (transition == HueTransition::None)
+			return;
 
-			randEndHues[particle->id] = ParticleMath::between(end1, end2, Random::range(0.0f, 1.0f));
+		// Hues are computed a block at a time, then written into the packed colors in one pass.
+		const int32_t blockSize = 256;
+		float values[blockSize];
+		for (int32_t blockStart = start; blockStart < end; blockStart += blockSize) {
+			const int32_t count = (end - blockStart) < blockSize ? (end - blockStart) : blockSize;
+			const int32_t* const ids = &buffer->id[blockStart];
+			const float* const life = &buffer->life[blockStart];
+			switch (transition) {
+				case HueTransition::Lerp: {
+					ColorKernels::lerpChannel(startColors, ids, ColorChannel::Hue, end1, life, values, count);
+				} break;
+				case HueTransition::RandomLerp: {
+					ColorKernels::lerpChannel(startColors, ids, ColorChannel::Hue, end1, end2, random, life, values, count);
+				} break;
+				case HueTransition::Curve: {
+					curve->EvaluateBakedBatch(life, values, (size_t)count);
+				} break;
+				case HueTransition::None:
+					break;
+			}
+			ColorKernels::setHue(&buffer->color[blockStart], values, count);
 		}
 	}
 
-	void NativeHueModule::onUpdate(const float deltaTime, Particle* const particleArrPtr, const int32_t length)
+	const uint32_t NativeHueModule::getReadStreams()
+	{
+		return ParticleStream::Id | ParticleStream::Life | ParticleStream::Color;
+	}
+
+	const uint32_t NativeHueModule::getWriteStreams()
+	{
+		if (transition == HueTransition::None)
+			return ParticleStream::None;
+
+		return ParticleStream::Color;
+	}
+
+	const uint32_t NativeHueModule::getAttributes()
 	{
 		switch (transition) {
-			case HueTransition::Lerp: {
-				#pragma omp simd
-				for (int32_t i = 0; i < length; i++) {
-					Particle* particle = &particleArrPtr[i];
-					particle->color.setHue(ParticleMath::lerp(startHuesArr[particle->id], end1, particle->timeAlive / particle->initialLife));
-				}
-			} break;
-			case HueTransition::RandomLerp: {
-				#pragma omp simd
-				for (int32_t i = 0; i < length; i++) {
-					Particle* particle = &particleArrPtr[i];
-					particle->color.setHue(ParticleMath::lerp(startHuesArr[particle->id], randEndHues[particle->id], particle->timeAlive / particle->initialLife));
-				}
-			} break;
-			case HueTransition::Curve: {
-				for (int32_t i = 0; i < length; i++) {
-					Particle* particle = &particleArrPtr[i];
-					particle->color.setHue(curve->Evaluate(particle->timeAlive / particle->initialLife));
-				}
-			} break;
-			case HueTransition::None:
-				break;
+			case HueTransition::Lerp:
+				return ParticleAttribute::StartColor;
+			case HueTransition::RandomLerp:
+				return ParticleAttribute::StartColor | ParticleAttribute::Random3;
+			default:
+				return ParticleAttribute::None;
 		}
 	}
 
@@ -105,12 +119,12 @@ namespace Particles {
 			delete this->curve;
 
 		this->curve = curve;
+		if (curve != nullptr)
+			curve->EnsureBaked();
 	}
 
 	NativeHueModule::~NativeHueModule()
 	{
-		delete[] startHuesArr;
-		delete[] randEndHues;
 		delete curve;
 	}
 
@@ -1,7 +1,7 @@
 #include "NativeLightnessModule.h"
 #include "ParticleMath.h"
 #include "Particle.h"
-#include "src/Utility/Random.h"
+#include "ColorKernels.h"
 
 namespace Particles {
 
@@ -17,57 +17,71 @@ namespace Particles {
 		if (!isRandom() || !isInitialized)
 			return;
 
-		delete[] randEndLightness;
-		randEndLightness = new float[particlesLength];
+		randomHandle = arena->acquire(ParticleAttribute::Random5);
 	}
 
 	void NativeLightnessModule::onInitialize(const int32_t particleArrayLength)
 	{
 		particlesLength = particleArrayLength;
-		startLightnessArr = new float[particleArrayLength];
+		startColorsHandle = arena->acquire(ParticleAttribute::StartColor);
 		isInitialized = true;
 
 		regenerateRandom();
 	}
 
-	void NativeLightnessModule::onParticlesActivated(const int32_t* const particleIndexArr, Particle* const particlesArrPtr, const int32_t length)
+	void NativeLightnessModule::onUpdate(const float deltaTime, ParticleBuffer* const buffer, const int32_t start, const int32_t end)
 	{
-		for (int32_t i = 0; i < length; i++) {
-			int32_t pIndex = particleIndexArr[i];
-			Particle* particle = &particlesArrPtr[pIndex];
-			startLightnessArr[particle->id] = particle->color.getLightness();
-			if (!isRandom())
-				continue;
+		const ParticleColor* const startColors = arena->get<ParticleColor>(startColorsHandle);
+		const float* const random = arena->get<float>(randomHandle);
+		if (transition == LightnessTransition::None)
+			return;
 
-			randEndLightness[particle->id] = ParticleMath::between(end1, end2, Random::range(0.0f, 1.0f));
+		// Lightness values are computed a block at a time, then written into the packed colors in one pass.
+		const int32_t blockSize = 256;
+		float values[blockSize];
+		for (int32_t blockStart = start; blockStart < end; blockStart += blockSize) {
+			const int32_t count = (end - blockStart) < blockSize ? (end - blockStart) : blockSize;
+			const int32_t* const ids = &buffer->id[blockStart];
+			const float* const life = &buffer->life[blockStart];
+			switch (transition) {
+				case LightnessTransition::Lerp: {
+					ColorKernels::lerpChannel(startColors, ids, ColorChannel::Lightness, end1, life, values, count);
+				} break;
+				case LightnessTransition::RandomLerp: {
+					ColorKernels::lerpChannel(startColors, ids, ColorChannel::Lightness, end1, end2, random, life, values, count);
+				} break;
+				case LightnessTransition::Curve: {
+					curve->EvaluateBakedBatch(life, values, (size_t)count);
+				} break;
+				case LightnessTransition::None:
+					break;
+			}
+			ColorKernels::setLightness(&buffer->color[blockStart], values, count);
 		}
 	}
 
-	void NativeLightnessModule::onUpdate(const float deltaTime, Particle* const particleArrPtr, const int32_t length)
+	const uint32_t NativeLightnessModule::getReadStreams()
+	{
+		return ParticleStream::Id | ParticleStream::Life | ParticleStream::Color;
+	}
+
+	const uint32_t NativeLightnessModule::getWriteStreams()
+	{
+		if (transition == LightnessTransition::None)
+			return ParticleStream::None;
+
+		return ParticleStream::Color;
+	}
+
+	const uint32_t NativeLightnessModule::getAttributes()
 	{
 		switch (transition) {
-			case LightnessTransition::Lerp: {
-				#pragma omp simd
-				for (int32_t i = 0; i < length; i++) {
-					Particle* particle = &particleArrPtr[i];
-					particle->color.setLightness(ParticleMath::lerp(startLightnessArr[particle->id], end1, particle->timeAlive / particle->initialLife));
-				}
-			} break;
-			case LightnessTransition::RandomLerp: {
-				#pragma omp simd
-				for (int32_t i = 0; i < length; i++) {
-					Particle* particle = &particleArrPtr[i];
-					particle->color.setLightness(ParticleMath::lerp(startLightnessArr[particle->id], randEndLightness[particle->id], particle->timeAlive / particle->initialLife));
-				}
-			} break;
-			case LightnessTransition::Curve: {
-				for (int32_t i = 0; i < length; i++) {
-					Particle* particle = &particleArrPtr[i];
-					particle->color.setLightness(curve->Evaluate(particle->timeAlive / particle->initialLife));
-				}
-			} break;
-			case LightnessTransition::None:
-				break;
+			case LightnessTransition::Lerp:
+				return ParticleAttribute::StartColor;
+			case LightnessTransition::RandomLerp:
+				return ParticleAttribute::StartColor | ParticleAttribute::Random5;
+			default:
+				return ParticleAttribute::None;
 		}
 	}
 
@@ -105,12 +119,12 @@ namespace Particles {
 			delete this->curve;
 
 		this->curve = curve;
+		if (curve != nullptr)
+			curve->EnsureBaked();
 	}
 
 	NativeLightnessModule::~NativeLightnessModule()
 	{
-		delete[] startLightnessArr;
-		delete[] randEndLightness;
 		delete curve;
 	}
 
@@ -19,8 +19,9 @@ namespace Particles {
 		LightnessTransition::Transition transition = LightnessTransition::None;
 		int particlesLength;
 		float end1, end2;
-		float* startLightnessArr = nullptr;
-		float* randEndLightness = nullptr;
+		// Shared attributes, as handles into the module's AttributeArena.
+		int32_t startColorsHandle = -1;
+		int32_t randomHandle = -1;
 		Curve* curve = nullptr;
 
 		void regenerateRandom();
@@ -30,8 +31,10 @@ namespace Particles {
 		NativeLightnessModule();
 
 		void onInitialize(const int32_t particleArrayLength) override;
-		void onParticlesActivated(const int32_t* const particleIndexArr, Particle* const particlesArrPtr, const int32_t length) override;
-		void onUpdate(float deltaTime, Particle* const particleArrPtr, const int32_t length) override;
+		void onUpdate(const float deltaTime, ParticleBuffer* const buffer, const int32_t start, const int32_t end) override;
+		const uint32_t getReadStreams() override;
+		const uint32_t getWriteStreams() override;
+		const uint32_t getAttributes() override;
 		const bool isValid() override;
 
 		void setNone();
@@ -1,11 +1,12 @@
 #include "NativeModule.h"
 #include "NativeAlphaModule.h"
 #include "ParticleMath.h"
+#include "src/Utility/ThreadPool.h"
 #include <stdexcept>
 
 namespace Particles 
 {
-	NativeModule::NativeModule()
+	NativeModule::NativeModule() : seed(RandomStream::nextDefaultSeed())
 	{ 
 		submodules = new std::vector<NativeSubmodule*>();
 	}
@@ -27,10 +28,12 @@ namespace Particles
 
 		// Create replacement vector.
 		for(NativeSubmodule* ptr : curSubmodules) {
-			if(ptr != submodule)
+			if(ptr != submodule) {
 				newSubmodules->push_back(ptr);
-			else
+			} else {
+				arena.release(ptr);
 				delete ptr;
+			}
 		}
 
 		// Delete current submodules.
@@ -43,20 +46,216 @@ namespace Particles
 
 	void NativeModule::onInitialize(NativeSubmodule* const submodulePtr, const int32_t particleArrayLength)
 	{
+		arena.reserve(particleArrayLength);
+		submodulePtr->setArena(&arena);
 		submodulePtr->onInitialize(particleArrayLength);
 	}
 
 	void NativeModule::onParticlesActivated(const int32_t* const particleIndexArr, Particle* const particlesArrPtr, const int32_t length)
 	{
-		for(NativeSubmodule* ptr : *submodules) {
-			ptr->onParticlesActivated(particleIndexArr, particlesArrPtr, length);
+		if (length <= 0)
+			return;
+
+		// Gather only the activated particles. Activation snapshots state, so nothing is scattered back.
+		uint32_t readStreams = getReadStreams() | getWriteStreams();
+		const uint32_t attributes = getAttributes();
+		if (attributes != ParticleAttribute::None)
+			readStreams |= ParticleStream::Id;
+		if (attributes & ParticleAttribute::StartColor)
+			readStreams |= ParticleStream::Color;
+		activationBuffer.resize(length);
+		activationBuffer.readFrom(particlesArrPtr, particleIndexArr, length, readStreams);
+		if (readStreams & ParticleStream::Life)
+			activationBuffer.updateLife(0, length);
+
+		onParticlesActivated(&activationBuffer, 0, length);
+	}
+
+	void NativeModule::onParticlesActivated(ParticleBuffer* const particles, const int32_t start, const int32_t end)
+	{
+		const int32_t length = end - start;
+		if (length <= 0)
+			return;
+
+		// Submodules only write id-indexed state here, so disjoint chunks can activate in parallel.
+		const int32_t chunkCount = (length + chunkSize - 1) / chunkSize;
+		const int32_t minGrain = ThreadPool::get().getMinGrainSize();
+		const int32_t grain = (minGrain + chunkSize - 1) / chunkSize;
+		const uint64_t activationSeed = seed + (activationCount++ * 0x9E3779B97F4A7C15ull);
+
+		// Named attributes are resolved up front, since acquiring one can grow the arena.
+		const uint32_t attributes = getAttributes();
+		ParticleColor* const startColors = (attributes & ParticleAttribute::StartColor)
+			? arena.get<ParticleColor>(arena.acquire(ParticleAttribute::StartColor))
+			: nullptr;
+		float* randoms[ParticleAttribute::RANDOM_COUNT];
+		for (int32_t i = 0; i < ParticleAttribute::RANDOM_COUNT; i++) {
+			const ParticleAttribute::Attribute attribute = (ParticleAttribute::Attribute)(ParticleAttribute::Random0 << i);
+			randoms[i] = (attributes & attribute) ? arena.get<float>(arena.acquire(attribute)) : nullptr;
 		}
+
+		ThreadPool::get().parallelForEach(0, chunkCount, grain, [&](const int32_t chunkBegin, const int32_t chunkEnd) {
+			for (int32_t chunk = chunkBegin; chunk < chunkEnd; chunk++) {
+				const int32_t rangeStart = start + (chunk * chunkSize);
+				const int32_t rangeEnd = (end - rangeStart) < chunkSize ? end : rangeStart + chunkSize;
+				RandomStream random(activationSeed, (uint64_t)chunk);
+				fillAttributes(particles, random, startColors, randoms, rangeStart, rangeEnd);
+				for (NativeSubmodule* ptr : *submodules) {
+					ptr->onParticlesActivated(particles, random, rangeStart, rangeEnd);
+				}
+			}
+		});
 	}
 
 	void NativeModule::onUpdate(const float deltaTime, Particle* const particleArrPtr, const int32_t length)
 	{
+		// Frame hooks run even with no particles alive, so per-frame state such as scrolling keeps advancing.
+		const int32_t count = length > 0 ? length : 0;
+		const uint32_t writeStreams = getWriteStreams();
+		const uint32_t readStreams = getReadStreams() | writeStreams;
+		buffer.resize(count);
+		beginFrame(deltaTime, &buffer, particleArrPtr, count);
+		if (count > 0)
+			updateChunks(deltaTime, &buffer, particleArrPtr, count, readStreams, writeStreams);
+	}
+
+	void NativeModule::onUpdate(const float deltaTime, ParticleBuffer* const particles, const int32_t length)
+	{
+		const int32_t count = length > 0 ? length : 0;
+		beginFrame(deltaTime, particles, nullptr, count);
+		if (count > 0)
+			updateChunks(deltaTime, particles, nullptr, count, ParticleStream::None, ParticleStream::None);
+	}
+
+	void NativeModule::beginFrame(const float deltaTime, ParticleBuffer* const particles, Particle* const particleArrPtr, const int32_t length)
+	{
+		// Chunks of managed particles are gathered lazily, so whole-system passes get their streams up front.
+		const uint32_t frameStreams = getFrameStreams();
+		if (length > 0 && particleArrPtr != nullptr && frameStreams != ParticleStream::None) {
+			ThreadPool::get().parallelFor(0, length, chunkSize, [&](const int32_t start, const int32_t end) {
+				particles->readFrom(particleArrPtr, start, end, frameStreams);
+				if (frameStreams & ParticleStream::Life)
+					particles->updateLife(start, end);
+			});
+		}
+		for (NativeSubmodule* ptr : *submodules) {
+			ptr->onFrameBegin(deltaTime, particles, length);
+		}
+	}
+
+	void NativeModule::updateChunks(const float deltaTime, ParticleBuffer* const particles, Particle* const particleArrPtr, const int32_t length, const uint32_t readStreams, const uint32_t writeStreams)
+	{
+		// Ranges are split across the thread pool. Within a range, unfused is a single chunk spanning all of it.
+		ThreadPool::get().parallelFor(0, length, chunkSize, [&](const int32_t start, const int32_t end) {
+			const int32_t step = fusedUpdate ? chunkSize : end - start;
+			for (int32_t chunkStart = start; chunkStart < end; chunkStart += step) {
+				const int32_t chunkEnd = (end - chunkStart) < step ? end : chunkStart + step;
+				updateRange(deltaTime, particles, particleArrPtr, chunkStart, chunkEnd, readStreams, writeStreams);
+			}
+		});
+	}
+
+	void NativeModule::updateRange(const float deltaTime, ParticleBuffer* const particles, Particle* const particleArrPtr, const int32_t start, const int32_t end, const uint32_t readStreams, const uint32_t writeStreams)
+	{
+		// Particles owned by managed code are bridged through the SoA buffer chunk by chunk.
+		if (particleArrPtr != nullptr) {
+			particles->readFrom(particleArrPtr, start, end, readStreams);
+			if (readStreams & ParticleStream::Life)
+				particles->updateLife(start, end);
+		}
+
 		for(NativeSubmodule* ptr : *submodules){
-			ptr->onUpdate(deltaTime, particleArrPtr, length);
+			ptr->onUpdate(deltaTime, particles, start, end);
+		}
+
+		if (particleArrPtr != nullptr)
+			particles->writeTo(particleArrPtr, start, end, writeStreams);
+	}
+
+	bool NativeModule::getFusedUpdate()
+	{
+		return fusedUpdate;
+	}
+
+	void NativeModule::setFusedUpdate(const bool val)
+	{
+		fusedUpdate = val;
+	}
+
+	int32_t NativeModule::getChunkSize()
+	{
+		return chunkSize;
+	}
+
+	void NativeModule::setChunkSize(const int32_t val)
+	{
+		if (val <= 0)
+			throw std::invalid_argument("Chunk size must be positive!");
+
+		chunkSize = val;
+	}
+
+	uint64_t NativeModule::getSeed()
+	{
+		return seed;
+	}
+
+	void NativeModule::setSeed(const uint64_t val)
+	{
+		// Restarts the activation sequence, so the same seed reproduces the same particles.
+		seed = val;
+		activationCount = 0;
+	}
+
+	const uint32_t NativeModule::getReadStreams()
+	{
+		uint32_t streams = ParticleStream::None;
+		for (NativeSubmodule* ptr : *submodules) {
+			streams |= ptr->getReadStreams();
+		}
+		return streams;
+	}
+
+	const uint32_t NativeModule::getWriteStreams()
+	{
+		uint32_t streams = ParticleStream::None;
+		for (NativeSubmodule* ptr : *submodules) {
+			streams |= ptr->getWriteStreams();
+		}
+		return streams;
+	}
+
+	const uint32_t NativeModule::getFrameStreams()
+	{
+		uint32_t streams = ParticleStream::None;
+		for (NativeSubmodule* ptr : *submodules) {
+			streams |= ptr->getFrameStreams();
+		}
+		return streams;
+	}
+
+	const uint32_t NativeModule::getAttributes()
+	{
+		uint32_t attributes = ParticleAttribute::None;
+		for (NativeSubmodule* ptr : *submodules) {
+			attributes |= ptr->getAttributes();
+		}
+		return attributes;
+	}
+
+	void NativeModule::fillAttributes(ParticleBuffer* const particles, RandomStream& random, ParticleColor* const startColors, float* const* const randoms, const int32_t start, const int32_t end)
+	{
+		// Each attribute is written once here, however many submodules read it.
+		const int32_t* const __restrict ids = particles->id;
+		if (startColors != nullptr) {
+			const ParticleColor* const __restrict colors = particles->color;
+			for (int32_t i = start; i < end; i++) {
+				startColors[ids[i]] = colors[i];
+			}
+		}
+		for (int32_t i = 0; i < ParticleAttribute::RANDOM_COUNT; i++) {
+			if (randoms[i] != nullptr)
+				random.fillIndexed(randoms[i], &ids[start], end - start, 0.0f, 1.0f);
 		}
 	}
 
@@ -101,6 +300,36 @@ namespace Particles
 		modulePtr->onInitialize(submodulePtr, particleArrayLength);
 	}
 
+	LIB_API(bool) nativeModule_GetFusedUpdate(NativeModule* const modulePtr)
+	{
+		return modulePtr->getFusedUpdate();
+	}
+
+	LIB_API(void) nativeModule_SetFusedUpdate(NativeModule* const modulePtr, const bool val)
+	{
+		modulePtr->setFusedUpdate(val);
+	}
+
+	LIB_API(int32_t) nativeModule_GetChunkSize(NativeModule* const modulePtr)
+	{
+		return modulePtr->getChunkSize();
+	}
+
+	LIB_API(void) nativeModule_SetChunkSize(NativeModule* const modulePtr, const int32_t val)
+	{
+		modulePtr->setChunkSize(val);
+	}
+
+	LIB_API(uint64_t) nativeModule_GetSeed(NativeModule* const modulePtr)
+	{
+		return modulePtr->getSeed();
+	}
+
+	LIB_API(void) nativeModule_SetSeed(NativeModule* const modulePtr, const uint64_t val)
+	{
+		modulePtr->setSeed(val);
+	}
+
 	LIB_API(void) nativeModule_Delete(NativeModule* const modulePtr) 
 	{
 		delete modulePtr;
@@ -6,6 +6,8 @@
 #include "src/Utility.h"
 #include "src/SE.Native.h"
 #include "Particle.h"
+#include "ParticleBuffer.h"
+#include "AttributeArena.h"
 #include <vector>
 
 namespace Particles 
@@ -13,17 +15,59 @@ namespace Particles
 	class NativeSubmodule;
 	class NativeModule {
 	public:
+		// Particles per chunk in fused mode. 256 particles keep the gathered streams well inside L1/L2.
+		static const int32_t DEFAULT_CHUNK_SIZE = 256;
+
 		std::vector<NativeSubmodule*>* submodules;
 
 		NativeModule();
 
+		bool getFusedUpdate();
+		void setFusedUpdate(const bool val);
+		int32_t getChunkSize();
+		void setChunkSize(const int32_t val);
+		uint64_t getSeed();
+		void setSeed(const uint64_t val);
+
 		void addSubmodule(NativeSubmodule* const submodule);
 		void removeSubmodule(NativeSubmodule* const submodule);
 		void onInitialize(NativeSubmodule* const submodulePtr, const int32_t particleArrayLength);
 		void onParticlesActivated(const int32_t* const particleIndexArr, Particle* const particlesArrPtr, const int32_t length);
 		void onUpdate(const float deltaTime, Particle* const particleArrPtr, const int32_t length);
 
+		// Natively owned particles. The buffer's normalized life must already be up to date.
+		void onParticlesActivated(ParticleBuffer* const particles, const int32_t start, const int32_t end);
+		void onUpdate(const float deltaTime, ParticleBuffer* const particles, const int32_t length);
+
 		~NativeModule();
+
+	private:
+		// SoA working set. The AoS particle array is gathered into this, processed, then scattered back.
+		ParticleBuffer buffer;
+		ParticleBuffer activationBuffer;
+
+		// Side arrays of every submodule, in one aligned allocation sized to the particle capacity.
+		AttributeArena arena;
+
+		// Fused mode runs every submodule over one chunk before moving to the next, instead of
+		// sweeping the whole array once per submodule.
+		bool fusedUpdate = true;
+		int32_t chunkSize = DEFAULT_CHUNK_SIZE;
+
+		// Activation randomness. Each chunk of each activation call gets its own stream derived
+		// from these, so results don't depend on how chunks are spread over threads.
+		uint64_t seed;
+		uint64_t activationCount = 0;
+
+		void beginFrame(const float deltaTime, ParticleBuffer* const particles, Particle* const particleArrPtr, const int32_t length);
+		void updateChunks(const float deltaTime, ParticleBuffer* const particles, Particle* const particleArrPtr, const int32_t length, const uint32_t readStreams, const uint32_t writeStreams);
+		void updateRange(const float deltaTime, ParticleBuffer* const particles, Particle* const particleArrPtr, const int32_t start, const int32_t end, const uint32_t readStreams, const uint32_t writeStreams);
+
+		const uint32_t getReadStreams();
+		const uint32_t getWriteStreams();
+		const uint32_t getFrameStreams();
+		const uint32_t getAttributes();
+		void fillAttributes(ParticleBuffer* const particles, RandomStream& random, ParticleColor* const startColors, float* const* const randoms, const int32_t start, const int32_t end);
 	};
 }
 
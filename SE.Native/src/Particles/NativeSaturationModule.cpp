@@ -1,6 +1,7 @@
 #include "NativeSaturationModule.h"
 #include "ParticleMath.h"
 #include "Particle.h"
+#include "ColorKernels.h"
 #include "src/Utility.h"
 
 namespace Particles {
@@ -17,57 +18,71 @@ namespace Particles {
 		if (!isRandom() || !isInitialized)
 			return;
 
-		delete[] randEndSaturation;
-		randEndSaturation = new float[particlesLength];
+		randomHandle = arena->acquire(ParticleAttribute::Random4);
 	}
 
 	void NativeSaturationModule::onInitialize(const int32_t particleArrayLength)
 	{
 		particlesLength = particleArrayLength;
-		startSaturationArr = new float[particleArrayLength];
+		startColorsHandle = arena->acquire(ParticleAttribute::StartColor);
 		isInitialized = true;
 
 		regenerateRandom();
 	}
 
-	void NativeSaturationModule::onParticlesActivated(const int32_t* const particleIndexArr, Particle* const particlesArrPtr, const int32_t length)
+	void NativeSaturationModule::onUpdate(const float deltaTime, ParticleBuffer* const buffer, const int32_t start, const int32_t end)
 	{
-		for (int32_t i = 0; i < length; i++) {
-			int32_t pIndex = particleIndexArr[i];
-			Particle* particle = &particlesArrPtr[pIndex];
-			startSaturationArr[particle->id] = particle->color.getSaturation();
-			if (!isRandom())
-				continue;
+		const ParticleColor* const startColors = arena->get<ParticleColor>(startColorsHandle);
+		const float* const random = arena->get<float>(randomHandle);
+		if (transition == SaturationTransition::None)
+			return;
 
-			randEndSaturation[particle->id] = ParticleMath::between(end1, end2, Random::range(0.0f, 1.0f));
+		// Saturations are computed a block at a time, then written into the packed colors in one pass.
+		const int32_t blockSize = 256;
+		float values[blockSize];
+		for (int32_t blockStart = start; blockStart < end; blockStart += blockSize) {
+			const int32_t count = (end - blockStart) < blockSize ? (end - blockStart) : blockSize;
+			const int32_t* const ids = &buffer->id[blockStart];
+			const float* const life = &buffer->life[blockStart];
+			switch (transition) {
+				case SaturationTransition::Lerp: {
+					ColorKernels::lerpChannel(startColors, ids, ColorChannel::Saturation, end1, life, values, count);
+				} break;
+				case SaturationTransition::RandomLerp: {
+					ColorKernels::lerpChannel(startColors, ids, ColorChannel::Saturation, end1, end2, random, life, values, count);
+				} break;
+				case SaturationTransition::Curve: {
+					curve->EvaluateBakedBatch(life, values, (size_t)count);
+				} break;
+				case SaturationTransition::None:
+					break;
+			}
+			ColorKernels::setSaturation(&buffer->color[blockStart], values, count);
 		}
 	}
 
-	void NativeSaturationModule::onUpdate(const float deltaTime, Particle* const particleArrPtr, const int32_t length)
+	const uint32_t NativeSaturationModule::getReadStreams()
+	{
+		return ParticleStream::Id | ParticleStream::Life | ParticleStream::Color;
+	}
+
+	const uint32_t NativeSaturationModule::getWriteStreams()
+	{
+		if (transition == SaturationTransition::None)
+			return ParticleStream::None;
+
+		return ParticleStream::Color;
+	}
+
+	const uint32_t NativeSaturationModule::getAttributes()
 	{
 		switch (transition) {
-			case SaturationTransition::Lerp: {
-				#pragma omp simd
-				for (int32_t i = 0; i < length; i++) {
-					Particle* particle = &particleArrPtr[i];
-					particle->color.setSaturation(ParticleMath::lerp(startSaturationArr[particle->id], end1, particle->timeAlive / particle->initialLife));
-				}
-			} break;
-			case SaturationTransition::RandomLerp: {
-				#pragma omp simd
-				for (int32_t i = 0; i < length; i++) {
-					Particle* particle = &particleArrPtr[i];
-					particle->color.setSaturation(ParticleMath::lerp(startSaturationArr[particle->id], randEndSaturation[particle->id], particle->timeAlive / particle->initialLife));
-				}
-			} break;
-			case SaturationTransition::Curve: {
-				for (int32_t i = 0; i < length; i++) {
-					Particle* particle = &particleArrPtr[i];
-					particle->color.setSaturation(curve->Evaluate(particle->timeAlive / particle->initialLife));
-				}
-			} break;
-			case SaturationTransition::None:
-				break;
+			case SaturationTransition::Lerp:
+				return ParticleAttribute::StartColor;
+			case SaturationTransition::RandomLerp:
+				return ParticleAttribute::StartColor | ParticleAttribute::Random4;
+			default:
+				return ParticleAttribute::None;
 		}
 	}
 
@@ -105,12 +120,12 @@ namespace Particles {
 			delete this->curve;
 
 		this->curve = curve;
+		if (curve != nullptr)
+			curve->EnsureBaked();
 	}
 
 	NativeSaturationModule::~NativeSaturationModule()
 	{
-		delete[] startSaturationArr;
-		delete[] randEndSaturation;
 		delete curve;
 	}
 
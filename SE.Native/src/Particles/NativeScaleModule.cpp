@@ -17,59 +17,60 @@ namespace Particles {
 		if (!isRandom() || !isInitialized)
 			return;
 
-		delete[] rand;
-		rand = new float[particlesLength];
+		randHandle = arena->acquire(ParticleAttribute::Random0);
 	}
 
 	void NativeScaleModule::onInitialize(const int32_t particleArrayLength)
 	{
 		particlesLength = particleArrayLength;
-		startScalesArr = new Vector2[particleArrayLength];
+		startScalesHandle = arena->acquire(this, 0, sizeof(Vector2));
 		isInitialized = true;
 
 		regenerateRandom();
 	}
 
-	void NativeScaleModule::onParticlesActivated(const int32_t* const particleIndexArr, Particle* const particlesArrPtr, const int32_t length)
+	void NativeScaleModule::onParticlesActivated(ParticleBuffer* const buffer, RandomStream& random, const int32_t start, const int32_t end)
 	{
-		for (int32_t i = 0; i < length; i++) {
-			int32_t pIndex = particleIndexArr[i];
-			int32_t pId = particlesArrPtr[pIndex].id;
-			startScalesArr[pId] = particlesArrPtr[pIndex].scale;
-			if (!isRandom())
-				continue;
-
-			rand[particleIndexArr[pId]] = Random::range(0.0f, 1.0f);
+		Vector2* const startScalesArr = arena->get<Vector2>(startScalesHandle);
+		const int32_t* const __restrict ids = buffer->id;
+		const float* const __restrict scaleX = buffer->scaleX;
+		const float* const __restrict scaleY = buffer->scaleY;
+		for (int32_t i = start; i < end; i++) {
+			startScalesArr[ids[i]] = Vector2(scaleX[i], scaleY[i]);
 		}
 	}
 
-	void NativeScaleModule::onUpdate(const float deltaTime, Particle* const particleArrPtr, const int32_t length)
+	void NativeScaleModule::onUpdate(const float deltaTime, ParticleBuffer* const buffer, const int32_t start, const int32_t end)
 	{
+		Vector2* const startScalesArr = arena->get<Vector2>(startScalesHandle);
+		const int32_t* const __restrict ids = buffer->id;
+		const float* const __restrict life = buffer->life;
+		float* const __restrict scaleX = buffer->scaleX;
+		float* const __restrict scaleY = buffer->scaleY;
 		if (absoluteValue) {
 			switch (transition) {
 				case ScaleTransition::Lerp: {
 					#pragma omp simd
-					for (int32_t i = 0; i < length; i++) {
-						Particle* particle = &particleArrPtr[i];
-						const float scale = ParticleMath::between(start, end, particle->timeAlive / particle->initialLife);
-						particle->scale.x = scale;
-						particle->scale.y = scale;
+					for (int32_t i = start; i < end; i++) {
+						const float scale = ParticleMath::between(this->start, this->end, life[i]);
+						scaleX[i] = scale;
+						scaleY[i] = scale;
 					}
 				} break;
 				case ScaleTransition::Curve: {
-					for (int32_t i = 0; i < length; i++) {
-						Particle* particle = &particleArrPtr[i];
-						const float scale = curve->Evaluate(particle->timeAlive / particle->initialLife);
-						particle->scale.x = scale;
-						particle->scale.y = scale;
+					#pragma omp simd
+					for (int32_t i = start; i < end; i++) {
+						const float scale = curve->EvaluateBaked(life[i]);
+						scaleX[i] = scale;
+						scaleY[i] = scale;
 					}
 				} break;
 				case ScaleTransition::RandomCurve: {
-					for (int32_t i = 0; i < length; i++) {
-						Particle* particle = &particleArrPtr[i];
-						const float scale = curve->Evaluate(particle->timeAlive / particle->initialLife);
-						particle->scale.x = scale;
-						particle->scale.y = scale;
+					#pragma omp simd
+					for (int32_t i = start; i < end; i++) {
+						const float scale = curve->EvaluateBaked(life[i]);
+						scaleX[i] = scale;
+						scaleY[i] = scale;
 					}
 				} break;
 				case ScaleTransition::None:
@@ -79,30 +80,29 @@ namespace Particles {
 			switch (transition) {
 				case ScaleTransition::Lerp: {
 					#pragma omp simd
-					for (int32_t i = 0; i < length; i++) {
-						Particle* particle = &particleArrPtr[i];
-						const float scale = ParticleMath::between(start, end, particle->timeAlive / particle->initialLife);
-						const int32_t pId = particle->id;
-						particle->scale.x = scale * startScalesArr[pId].x;
-						particle->scale.y = scale * startScalesArr[pId].y;
+					for (int32_t i = start; i < end; i++) {
+						const float scale = ParticleMath::between(this->start, this->end, life[i]);
+						const int32_t pId = ids[i];
+						scaleX[i] = scale * startScalesArr[pId].x;
+						scaleY[i] = scale * startScalesArr[pId].y;
 					}
 				} break;
 				case ScaleTransition::Curve: {
-					for (int32_t i = 0; i < length; i++) {
-						Particle* particle = &particleArrPtr[i];
-						const float scale = curve->Evaluate(particle->timeAlive / particle->initialLife);
-						const int32_t pId = particle->id;
-						particle->scale.x = scale * startScalesArr[pId].x;
-						particle->scale.y = scale * startScalesArr[pId].y;
+					#pragma omp simd
+					for (int32_t i = start; i < end; i++) {
+						const float scale = curve->EvaluateBaked(life[i]);
+						const int32_t pId = ids[i];
+						scaleX[i] = scale * startScalesArr[pId].x;
+						scaleY[i] = scale * startScalesArr[pId].y;
 					}
 				} break;
 				case ScaleTransition::RandomCurve: {
-					for (int32_t i = 0; i < length; i++) {
-						Particle* particle = &particleArrPtr[i];
-						const float scale = curve->Evaluate(particle->timeAlive / particle->initialLife);
-						const int32_t pId = particle->id;
-						particle->scale.x = scale * startScalesArr[pId].x;
-						particle->scale.y = scale * startScalesArr[pId].y;
+					#pragma omp simd
+					for (int32_t i = start; i < end; i++) {
+						const float scale = curve->EvaluateBaked(life[i]);
+						const int32_t pId = ids[i];
+						scaleX[i] = scale * startScalesArr[pId].x;
+						scaleY[i] = scale * startScalesArr[pId].y;
 					}
 				} break;
 				case ScaleTransition::None:
@@ -111,6 +111,24 @@ namespace Particles {
 		}
 	}
 
+	const uint32_t NativeScaleModule::getReadStreams()
+	{
+		return ParticleStream::Id | ParticleStream::Life | ParticleStream::Scale;
+	}
+
+	const uint32_t NativeScaleModule::getWriteStreams()
+	{
+		if (transition == ScaleTransition::None)
+			return ParticleStream::None;
+
+		return ParticleStream::Scale;
+	}
+
+	const uint32_t NativeScaleModule::getAttributes()
+	{
+		return isRandom() ? ParticleAttribute::Random0 : ParticleAttribute::None;
+	}
+
 	const bool NativeScaleModule::isValid()
 	{
 		return false; // ???
@@ -145,6 +163,8 @@ namespace Particles {
 			delete this->curve;
 
 		this->curve = curve;
+		if (curve != nullptr)
+			curve->EnsureBaked();
 	}
 
 	void NativeScaleModule::setRandomCurve(Curve* const curve)
@@ -154,12 +174,12 @@ namespace Particles {
 			delete this->curve;
 
 		this->curve = curve;
+		if (curve != nullptr)
+			curve->EnsureBaked();
 	}
 
 	NativeScaleModule::~NativeScaleModule()
 	{
-		delete[] startScalesArr;
-		delete[] rand;
 		delete curve;
 	}
 
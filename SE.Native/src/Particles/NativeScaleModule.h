@@ -19,8 +19,9 @@ namespace Particles {
 		ScaleTransition::Transition transition = ScaleTransition::None;
 		int particlesLength;
 		float start, end;
-		Vector2* startScalesArr = nullptr;
-		float* rand = nullptr;
+		// Per-particle side arrays, as handles into the module's AttributeArena.
+		int32_t startScalesHandle = -1;
+		int32_t randHandle = -1;
 		Curve* curve = nullptr;
 
 		void regenerateRandom();
@@ -31,8 +32,11 @@ namespace Particles {
 		NativeScaleModule();
 
 		void onInitialize(const int32_t particleArrayLength) override;
-		void onParticlesActivated(const int32_t* const particleIndexArr, Particle* const particlesArrPtr, const int32_t length) override;
-		void onUpdate(float deltaTime, Particle* const particleArrPtr, const int32_t length) override;
+		void onParticlesActivated(ParticleBuffer* const buffer, RandomStream& random, const int32_t start, const int32_t end) override;
+		void onUpdate(const float deltaTime, ParticleBuffer* const buffer, const int32_t start, const int32_t end) override;
+		const uint32_t getReadStreams() override;
+		const uint32_t getWriteStreams() override;
+		const uint32_t getAttributes() override;
 		const bool isValid() override;
 
 		bool getAbsoluteValue();
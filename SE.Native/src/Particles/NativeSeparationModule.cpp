@@ -0,0 +1,208 @@
+#include "NativeSeparationModule.h"
+#include "ParticleMath.h"
+#include "Particle.h"
+#include "src/Utility.h"
+#include "src/Utility/ThreadPool.h"
+#include <math.h>
+#include <stdexcept>
+
+namespace Particles {
+
+	namespace {
+		// Adds the push from every 'stride'th entry of [first, last). 'SAMPLED' is false for rows under
+		// the cap, so their entries are read contiguously.
+		template<bool SAMPLED>
+		inline void accumulatePush(const float* const __restrict hashX, const float* const __restrict hashY, const int32_t first, const int32_t last, const int32_t stride,
+			const float x, const float y, const float radiusSquared, const float inverseRadius, float& outX, float& outY)
+		{
+			const int32_t step = SAMPLED ? stride : 1;
+			float sumX = 0.0f, sumY = 0.0f;
+			#pragma omp simd reduction(+:sumX, sumY)
+			for (int32_t k = first; k < last; k += step) {
+				const float offsetX = x - hashX[k];
+				const float offsetY = y - hashY[k];
+				const float distanceSquared = (offsetX * offsetX) + (offsetY * offsetY);
+				const float distance = sqrtf(distanceSquared);
+
+				// Coincident particles have no direction to separate along and get no push. Whatever
+				// shares a bucket without being nearby fails the radius test.
+				const float inside = (distanceSquared < radiusSquared && distanceSquared > 0.0f) ? 1.0f : 0.0f;
+				const float weight = inside * (1.0f - (distance * inverseRadius)) / (distance > 0.0f ? distance : 1.0f);
+				sumX += offsetX * weight;
+				sumY += offsetY * weight;
+			}
+			outX += sumX;
+			outY += sumY;
+		}
+	}
+
+	NativeSeparationModule::NativeSeparationModule() : NativeSubmodule() { }
+
+	bool NativeSeparationModule::isActive()
+	{
+		return radius > 0.0f && strength != 0.0f;
+	}
+
+	void NativeSeparationModule::onInitialize(const int32_t particleArrayLength)
+	{
+		particlesLength = particleArrayLength;
+		isInitialized = true;
+	}
+
+	void NativeSeparationModule::onFrameBegin(const float deltaTime, ParticleBuffer* const buffer, const int32_t length)
+	{
+		if (!isActive())
+			return;
+
+		hash.build(buffer->positionX, buffer->positionY, length, radius);
+		if ((int32_t)forceX.size() < length) {
+			forceX.resize(length);
+			forceY.resize(length);
+		}
+
+		// Forces are gathered in hash order rather than particle order: neighboring entries share
+		// their 3x3 neighborhood, so it stays in cache. Results are scattered back by particle index.
+		ThreadPool::get().parallelFor(0, length, QUERY_GRAIN, [&](const int32_t start, const int32_t end) {
+			gatherForces(start, end);
+		});
+	}
+
+	void NativeSeparationModule::gatherForces(const int32_t start, const int32_t end)
+	{
+		const int32_t* const bucketStart = hash.getBucketStart();
+		const int32_t* const __restrict indices = hash.getIndices();
+		const float* const __restrict hashX = hash.getPositionX();
+		const float* const __restrict hashY = hash.getPositionY();
+		float* const __restrict outX = forceX.data();
+		float* const __restrict outY = forceY.data();
+		const int32_t bucketCount = hash.getBucketCount();
+		const float radiusSquared = radius * radius;
+		const float inverseRadius = 1.0f / radius;
+
+		for (int32_t slot = start; slot < end; slot++) {
+			const float x = hashX[slot];
+			const float y = hashY[slot];
+			const int32_t cellX = hash.cellCoordinate(x);
+			const int32_t cellY = hash.cellCoordinate(y);
+
+			// Each row of the 3x3 neighborhood is three consecutive buckets, so one contiguous run of
+			// entries unless it wraps around the end of the table. Rows over the cap are sampled at an
+			// even stride: taking the first entries would only ever see the left column, and push the
+			// whole pile right.
+			int32_t runStart[6], runEnd[6], runStride[6];
+			int32_t runCount = 0;
+			for (int32_t offsetY = -1; offsetY <= 1; offsetY++) {
+				const int32_t first = hash.getBucket(cellX - 1, cellY + offsetY);
+				if (first + 3 <= bucketCount) {
+					const int32_t rowLength = bucketStart[first + 3] - bucketStart[first];
+					runStride[runCount] = rowLength > maxPerRow ? (rowLength + maxPerRow - 1) / maxPerRow : 1;
+					runStart[runCount] = bucketStart[first];
+					runEnd[runCount++] = bucketStart[first + 3];
+				} else {
+					const int32_t rowLength = (bucketStart[bucketCount] - bucketStart[first]) + bucketStart[first + 3 - bucketCount];
+					const int32_t stride = rowLength > maxPerRow ? (rowLength + maxPerRow - 1) / maxPerRow : 1;
+					runStride[runCount] = stride;
+					runStart[runCount] = bucketStart[first];
+					runEnd[runCount++] = bucketStart[bucketCount];
+					runStride[runCount] = stride;
+					runStart[runCount] = bucketStart[0];
+					runEnd[runCount++] = bucketStart[first + 3 - bucketCount];
+				}
+			}
+
+			float sumX = 0.0f, sumY = 0.0f;
+			for (int32_t run = 0; run < runCount; run++) {
+				const int32_t first = runStart[run];
+				const int32_t last = runEnd[run];
+				if (runStride[run] > 1) {
+					accumulatePush<true>(hashX, hashY, first, last, runStride[run], x, y, radiusSquared, inverseRadius, sumX, sumY);
+				} else {
+					accumulatePush<false>(hashX, hashY, first, last, 1, x, y, radiusSquared, inverseRadius, sumX, sumY);
+				}
+			}
+			outX[indices[slot]] = sumX;
+			outY[indices[slot]] = sumY;
+		}
+	}
+
+	void NativeSeparationModule::onUpdate(const float deltaTime, ParticleBuffer* const buffer, const int32_t start, const int32_t end)
+	{
+		if (!isActive())
+			return;
+
+		const float* const __restrict mass = buffer->mass;
+		const float* const __restrict pushX = forceX.data();
+		const float* const __restrict pushY = forceY.data();
+		float* const __restrict directionX = buffer->directionX;
+		float* const __restrict directionY = buffer->directionY;
+		float* const __restrict speed = buffer->speed;
+		const float impulse = strength * deltaTime;
+
+		#pragma omp simd
+		for (int32_t i = start; i < end; i++) {
+			const float particleMass = mass[i];
+			const float scale = impulse / (particleMass > 0.0f ? particleMass : 1.0f);
+			const float velocityX = (directionX[i] * speed[i]) + (pushX[i] * scale);
+			const float velocityY = (directionY[i] * speed[i]) + (pushY[i] * scale);
+			ParticleMath::setVelocity(velocityX, velocityY, &directionX[i], &directionY[i], &speed[i]);
+		}
+	}
+
+	const uint32_t NativeSeparationModule::getFrameStreams()
+	{
+		if (!isActive())
+			return ParticleStream::None;
+
+		return ParticleStream::Position;
+	}
+
+	const uint32_t NativeSeparationModule::getReadStreams()
+	{
+		return ParticleStream::Mass | ParticleStream::Direction | ParticleStream::Speed;
+	}
+
+	const uint32_t NativeSeparationModule::getWriteStreams()
+	{
+		if (!isActive())
+			return ParticleStream::None;
+
+		return ParticleStream::Direction | ParticleStream::Speed;
+	}
+
+	const bool NativeSeparationModule::isValid()
+	{
+		return false; // ???
+	}
+
+	void NativeSeparationModule::setSeparation(const float radius, const float strength)
+	{
+		this->radius = radius > 0.0f ? radius : 0.0f;
+		this->strength = strength;
+	}
+
+	void NativeSeparationModule::setMaxPerRow(const int32_t val)
+	{
+		if (val <= 0)
+			throw std::invalid_argument("Max per row must be positive!");
+
+		maxPerRow = val;
+	}
+
+	NativeSeparationModule::~NativeSeparationModule() { }
+
+	LIB_API(NativeSeparationModule*) nativeModule_SeparationModule_Ctor()
+	{
+		return new NativeSeparationModule();
+	}
+
+	LIB_API(void) nativeModule_SeparationModule_SetSeparation(NativeSeparationModule* const modulePtr, const float radius, const float strength)
+	{
+		modulePtr->setSeparation(radius, strength);
+	}
+
+	LIB_API(void) nativeModule_SeparationModule_SetMaxPerRow(NativeSeparationModule* const modulePtr, const int32_t val)
+	{
+		modulePtr->setMaxPerRow(val);
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,58 @@
+#pragma once
+
+#ifndef NATIVESEPARATIONMODULE_H
+#define NATIVESEPARATIONMODULE_H
+
+#include "src/SE.Native.h"
+#include "Particle.h"
+#include "NativeSubmodule.h"
+#include "SpatialHash.h"
+#include "src/Utility.h"
+#include <vector>
+
+namespace Particles {
+
+	// Pushes particles closer than a radius apart. Once per frame positions are hashed into radius-sized
+	// cells and every particle scans its 3x3 neighborhood for the net push, which the update then
+	// applies to velocity. Force buffers grow with the particle count and are reused. The push is a force falling off
+	// linearly to 0 at the radius, divided by mass (mass <= 0 counts as 1).
+	class NativeSeparationModule final : NativeSubmodule {
+	public:
+		static const int32_t DEFAULT_MAX_PER_ROW = 64;
+		static const int32_t QUERY_GRAIN = 1024;
+
+	private:
+		int particlesLength;
+		float radius = 0.0f;
+		float strength = 0.0f;
+		int32_t maxPerRow = DEFAULT_MAX_PER_ROW;
+		SpatialHash hash;
+		std::vector<float> forceX;
+		std::vector<float> forceY;
+
+		bool isActive();
+		void gatherForces(const int32_t start, const int32_t end);
+
+	public:
+		NativeSeparationModule();
+
+		void onInitialize(const int32_t particleArrayLength) override;
+		void onFrameBegin(const float deltaTime, ParticleBuffer* const buffer, const int32_t length) override;
+		void onUpdate(const float deltaTime, ParticleBuffer* const buffer, const int32_t start, const int32_t end) override;
+		const uint32_t getFrameStreams() override;
+		const uint32_t getReadStreams() override;
+		const uint32_t getWriteStreams() override;
+		const bool isValid() override;
+
+		void setSeparation(const float radius, const float strength);
+
+		// Neighbors considered per row of three cells, the particle itself included. Bounds the cost
+		// of dense piles, where particles don't need every neighbor to spread out. Fuller rows are
+		// sampled evenly across all three cells.
+		void setMaxPerRow(const int32_t val);
+
+		~NativeSeparationModule() override;
+	};
+}
+
+#endif
\ No newline at end of file
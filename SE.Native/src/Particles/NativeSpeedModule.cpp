@@ -17,8 +17,7 @@ namespace Particles {
 		if (!isRandom() || !isInitialized)
 			return;
 
-		delete[] rand;
-		rand = new float[particlesLength];
+		randHandle = arena->acquire(ParticleAttribute::Random1);
 	}
 
 	void NativeSpeedModule::onInitialize(const int32_t particleArrayLength)
@@ -29,41 +28,33 @@ namespace Particles {
 		regenerateRandom();
 	}
 
-	void NativeSpeedModule::onParticlesActivated(const int32_t* const particleIndexArr, Particle* const particlesArrPtr, const int32_t length)
-	{
-		for (int32_t i = 0; i < length; i++) {
-			if (!isRandom())
-				continue;
-
-			Particle* particle = &particlesArrPtr[particleIndexArr[i]];
-			rand[particle->id] = Random::range(0.0f, 1.0f);
-		}
-	}
-
-	void NativeSpeedModule::onUpdate(const float deltaTime, Particle* const particleArrPtr, const int32_t length)
+	void NativeSpeedModule::onUpdate(const float deltaTime, ParticleBuffer* const buffer, const int32_t start, const int32_t end)
 	{
+		const float* const rand = arena->get<float>(randHandle);
+		const int32_t* const __restrict ids = buffer->id;
+		const float* const __restrict life = buffer->life;
+		float* const __restrict speed = buffer->speed;
 		if (absoluteValue) {
 			switch (transition) {
 				case SpeedTransition::Lerp: {
 					#pragma omp simd
-					for (int32_t i = 0; i < length; i++) {
-						Particle* particle = &particleArrPtr[i];
-						const float velocity = ParticleMath::lerp(start, end, particle->timeAlive / particle->initialLife);
-						particle->speed = velocity;
+					for (int32_t i = start; i < end; i++) {
+						const float velocity = ParticleMath::lerp(this->start, this->end, life[i]);
+						speed[i] = velocity;
 					}
 				} break;
 				case SpeedTransition::Curve: {
-					for (int32_t i = 0; i < length; i++) {
-						Particle* particle = &particleArrPtr[i];
-						const float velocity = curve->Evaluate(particle->timeAlive / particle->initialLife);
-						particle->speed = velocity;
+					#pragma omp simd
+					for (int32_t i = start; i < end; i++) {
+						const float velocity = curve->EvaluateBaked(life[i]);
+						speed[i] = velocity;
 					}
 				} break;
 				case SpeedTransition::RandomCurve: {
-					for (int32_t i = 0; i < length; i++) {
-						Particle* particle = &particleArrPtr[i];
-						const float velocity = curve->Evaluate(rand[particle->id]);
-						particle->speed = velocity;
+					#pragma omp simd
+					for (int32_t i = start; i < end; i++) {
+						const float velocity = curve->EvaluateBaked(rand[ids[i]]);
+						speed[i] = velocity;
 					}
 				} break;
 				case SpeedTransition::None:
@@ -73,24 +64,23 @@ namespace Particles {
 			switch (transition) {
 				case SpeedTransition::Lerp: {
 					#pragma omp simd
-					for (int32_t i = 0; i < length; i++) {
-						Particle* particle = &particleArrPtr[i];
-						const float velocity = ParticleMath::lerp(start, end, particle->timeAlive / particle->initialLife);
-						particle->speed = particle->speed + (velocity * deltaTime);
+					for (int32_t i = start; i < end; i++) {
+						const float velocity = ParticleMath::lerp(this->start, this->end, life[i]);
+						speed[i] = speed[i] + (velocity * deltaTime);
 					}
 				} break;
 				case SpeedTransition::Curve: {
-					for (int32_t i = 0; i < length; i++) {
-						Particle* particle = &particleArrPtr[i];
-						const float velocity = curve->Evaluate(particle->timeAlive / particle->initialLife);
-						particle->speed = particle->speed + (velocity * deltaTime);
+					#pragma omp simd
+					for (int32_t i = start; i < end; i++) {
+						const float velocity = curve->EvaluateBaked(life[i]);
+						speed[i] = speed[i] + (velocity * deltaTime);
 					}
 				} break;
 				case SpeedTransition::RandomCurve: {
-					for (int32_t i = 0; i < length; i++) {
-						Particle* particle = &particleArrPtr[i];
-						const float velocity = curve->Evaluate(rand[particle->id]);
-						particle->speed = particle->speed + (velocity * deltaTime);
+					#pragma omp simd
+					for (int32_t i = start; i < end; i++) {
+						const float velocity = curve->EvaluateBaked(rand[ids[i]]);
+						speed[i] = speed[i] + (velocity * deltaTime);
 					}
 				} break;
 				case SpeedTransition::None:
@@ -99,6 +89,24 @@ namespace Particles {
 		}
 	}
 
+	const uint32_t NativeSpeedModule::getReadStreams()
+	{
+		return ParticleStream::Id | ParticleStream::Life | ParticleStream::Speed;
+	}
+
+	const uint32_t NativeSpeedModule::getWriteStreams()
+	{
+		if (transition == SpeedTransition::None)
+			return ParticleStream::None;
+
+		return ParticleStream::Speed;
+	}
+
+	const uint32_t NativeSpeedModule::getAttributes()
+	{
+		return isRandom() ? ParticleAttribute::Random1 : ParticleAttribute::None;
+	}
+
 	const bool NativeSpeedModule::isValid()
 	{
 		return false; // ???
@@ -133,6 +141,8 @@ namespace Particles {
 			delete this->curve;
 
 		this->curve = curve;
+		if (curve != nullptr)
+			curve->EnsureBaked();
 	}
 
 	void NativeSpeedModule::setRandomCurve(Curve* const curve)
@@ -142,11 +152,12 @@ namespace Particles {
 			delete this->curve;
 
 		this->curve = curve;
+		if (curve != nullptr)
+			curve->EnsureBaked();
 	}
 
 	NativeSpeedModule::~NativeSpeedModule()
 	{
-		delete[] rand;
 		delete curve;
 	}
 
@@ -19,7 +19,8 @@ namespace Particles {
 		SpeedTransition::Transition transition = SpeedTransition::None;
 		int particlesLength;
 		float start, end;
-		float* rand = nullptr;
+		// Per-particle side arrays, as handles into the module's AttributeArena.
+		int32_t randHandle = -1;
 		Curve* curve = nullptr;
 
 		void regenerateRandom();
@@ -31,8 +32,10 @@ namespace Particles {
 		bool absoluteValue = false;
 
 		void onInitialize(const int32_t particleArrayLength) override;
-		void onParticlesActivated(const int32_t* const particleIndexArr, Particle* const particlesArrPtr, const int32_t length) override;
-		void onUpdate(float deltaTime, Particle* const particleArrPtr, const int32_t length) override;
+		void onUpdate(const float deltaTime, ParticleBuffer* const buffer, const int32_t start, const int32_t end) override;
+		const uint32_t getReadStreams() override;
+		const uint32_t getWriteStreams() override;
+		const uint32_t getAttributes() override;
 		const bool isValid() override;
 
 		bool getAbsoluteValue();
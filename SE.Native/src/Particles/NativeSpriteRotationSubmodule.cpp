@@ -17,8 +17,7 @@ namespace Particles {
 		if (!isRandom() || !isInitialized)
 			return;
 
-		delete[] rand;
-		rand = new float[particlesLength];
+		randHandle = arena->acquire(ParticleAttribute::Random2);
 	}
 
 	void NativeSpriteRotationModule::onInitialize(const int32_t particleArrayLength)
@@ -29,52 +28,42 @@ namespace Particles {
 		regenerateRandom();
 	}
 
-	void NativeSpriteRotationModule::onParticlesActivated(const int32_t* const particleIndexArr, Particle* const particlesArrPtr, const int32_t length)
-	{
-		for (int32_t i = 0; i < length; i++) {
-			if (!isRandom())
-				continue;
-
-			Particle* particle = &particlesArrPtr[particleIndexArr[i]];
-			rand[particle->id] = Random::range(0.0f, 1.0f);
-		}
-	}
-
-	void NativeSpriteRotationModule::onUpdate(const float deltaTime, Particle* const particleArrPtr, const int32_t length)
+	void NativeSpriteRotationModule::onUpdate(const float deltaTime, ParticleBuffer* const buffer, const int32_t start, const int32_t end)
 	{
+		const float* const rand = arena->get<float>(randHandle);
+		const int32_t* const __restrict ids = buffer->id;
+		const float* const __restrict life = buffer->life;
+		float* const __restrict rotation = buffer->spriteRotation;
 		switch (transition) {
 			case SpriteRotationTransition::Constant: {
 				#pragma omp simd
-				for (int32_t i = 0; i < length; i++) {
-					Particle* particle = &particleArrPtr[i];
-					particle->spriteRotation += start * deltaTime;
+				for (int32_t i = start; i < end; i++) {
+					rotation[i] += this->start * deltaTime;
 				}
 			} break;
 			case SpriteRotationTransition::Lerp: {
 				#pragma omp simd
-				for (int32_t i = 0; i < length; i++) {
-					Particle* particle = &particleArrPtr[i];
-					const float angleDelta = ParticleMath::lerp(start, end, particle->timeAlive / particle->initialLife);
-					particle->spriteRotation += angleDelta * deltaTime;
+				for (int32_t i = start; i < end; i++) {
+					const float angleDelta = ParticleMath::lerp(this->start, this->end, life[i]);
+					rotation[i] += angleDelta * deltaTime;
 				}
 			} break;
 			case SpriteRotationTransition::Curve: {
-				for (int32_t i = 0; i < length; i++) {
-					Particle* particle = &particleArrPtr[i];
-					particle->spriteRotation += curve->Evaluate(particle->timeAlive / particle->initialLife);
+				#pragma omp simd
+				for (int32_t i = start; i < end; i++) {
+					rotation[i] += curve->EvaluateBaked(life[i]);
 				}
 			} break;
 			case SpriteRotationTransition::RandomConstant: {
 				#pragma omp simd
-				for (int32_t i = 0; i < length; i++) {
-					Particle* particle = &particleArrPtr[i];
-					particle->spriteRotation += ParticleMath::between(start, end, rand[particle->id]) * deltaTime;
+				for (int32_t i = start; i < end; i++) {
+					rotation[i] += ParticleMath::between(this->start, this->end, rand[ids[i]]) * deltaTime;
 				}
 			} break;
 			case SpriteRotationTransition::RandomCurve: {
-				for (int32_t i = 0; i < length; i++) {
-					Particle* particle = &particleArrPtr[i];
-					particle->spriteRotation += curve->Evaluate(rand[particle->id]) * deltaTime;
+				#pragma omp simd
+				for (int32_t i = start; i < end; i++) {
+					rotation[i] += curve->EvaluateBaked(rand[ids[i]]) * deltaTime;
 				}
 			} break;
 			case SpriteRotationTransition::None:
@@ -82,6 +71,24 @@ namespace Particles {
 		}
 	}
 
+	const uint32_t NativeSpriteRotationModule::getReadStreams()
+	{
+		return ParticleStream::Id | ParticleStream::Life | ParticleStream::SpriteRotation;
+	}
+
+	const uint32_t NativeSpriteRotationModule::getWriteStreams()
+	{
+		if (transition == SpriteRotationTransition::None)
+			return ParticleStream::None;
+
+		return ParticleStream::SpriteRotation;
+	}
+
+	const uint32_t NativeSpriteRotationModule::getAttributes()
+	{
+		return isRandom() ? ParticleAttribute::Random2 : ParticleAttribute::None;
+	}
+
 	const bool NativeSpriteRotationModule::isValid()
 	{
 		return false; // ???
@@ -112,6 +119,8 @@ namespace Particles {
 			delete this->curve;
 
 		this->curve = curve;
+		if (curve != nullptr)
+			curve->EnsureBaked();
 	}
 
 	void NativeSpriteRotationModule::setRandomConstant(float min, float max) 
@@ -128,11 +137,12 @@ namespace Particles {
 			delete this->curve;
 
 		this->curve = curve;
+		if (curve != nullptr)
+			curve->EnsureBaked();
 	}
 
 	NativeSpriteRotationModule::~NativeSpriteRotationModule()
 	{
-		delete[] rand;
 		delete curve;
 	}
 
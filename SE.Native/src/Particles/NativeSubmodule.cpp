@@ -4,9 +4,19 @@
 namespace Particles {
 	NativeSubmodule::NativeSubmodule(){}
 
+	void NativeSubmodule::setArena(AttributeArena* const arena)
+	{
+		this->arena = arena;
+	}
+
 	void NativeSubmodule::onInitialize(const int32_t particleArrayLength) { }
-	void NativeSubmodule::onParticlesActivated(const int32_t* const particleIndexArr, Particle* const particlesArrPtr, const int32_t length) { }
-	void NativeSubmodule::onUpdate(const float deltaTime, Particle* const __restrict particleArrPtr, const int32_t length) { }
+	void NativeSubmodule::onParticlesActivated(ParticleBuffer* const buffer, RandomStream& random, const int32_t start, const int32_t end) { }
+	void NativeSubmodule::onUpdate(const float deltaTime, ParticleBuffer* const buffer, const int32_t start, const int32_t end) { }
+	const uint32_t NativeSubmodule::getReadStreams() { return ParticleStream::None; }
+	const uint32_t NativeSubmodule::getWriteStreams() { return ParticleStream::None; }
+	void NativeSubmodule::onFrameBegin(const float deltaTime, ParticleBuffer* const buffer, const int32_t length) { }
+	const uint32_t NativeSubmodule::getFrameStreams() { return ParticleStream::None; }
+	const uint32_t NativeSubmodule::getAttributes() { return ParticleAttribute::None; }
 	const bool NativeSubmodule::isValid() { return false; }
 	
 	NativeSubmodule::~NativeSubmodule()
@@ -4,6 +4,8 @@
 #define NATIVESUBMODULE_H
 
 #include "Particle.h"
+#include "ParticleBuffer.h"
+#include "AttributeArena.h"
 
 namespace Particles {
 	class NativeModule;
@@ -12,12 +14,29 @@ namespace Particles {
 		bool isInitialized = false;
 		int particlesLength;
 
+		// Per-particle side arrays live in the owning module's arena.
+		AttributeArena* arena = nullptr;
+
 	public:
 		NativeSubmodule();
 
+		// Called by the owning NativeModule before onInitialize.
+		void setArena(AttributeArena* const arena);
+
 		virtual void onInitialize(const int32_t particleArrayLength);
-		virtual void onParticlesActivated(const int32_t* const particleIndexArr, Particle* const particlesArrPtr, const int32_t length);
-		virtual void onUpdate(const float deltaTime, Particle* const __restrict particleArrPtr, const int32_t length);
+		virtual void onParticlesActivated(ParticleBuffer* const buffer, RandomStream& random, const int32_t start, const int32_t end);
+		virtual void onUpdate(const float deltaTime, ParticleBuffer* const buffer, const int32_t start, const int32_t end);
+		virtual const uint32_t getReadStreams();
+		virtual const uint32_t getWriteStreams();
+
+		// Once per update, before any chunk runs, with [0, length) of the buffer holding at least the
+		// getFrameStreams() streams. For per-frame state and whole-system passes such as building
+		// neighbor structures.
+		virtual void onFrameBegin(const float deltaTime, ParticleBuffer* const buffer, const int32_t length);
+		virtual const uint32_t getFrameStreams();
+
+		// Named attributes (ParticleAttribute) the submodule reads. The module fills them on activation.
+		virtual const uint32_t getAttributes();
 		virtual const bool isValid();
 
 		virtual ~NativeSubmodule();
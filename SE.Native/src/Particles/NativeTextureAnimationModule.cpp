@@ -2,44 +2,131 @@
 #include "ParticleMath.h"
 #include "Particle.h"
 #include "src/Utility.h"
+#include <stdexcept>
+#include <math.h>
 
 namespace Particles {
 
-	NativeTextureAnimationModule::NativeTextureAnimationModule() : NativeSubmodule() { }
+	bool NativeTextureAnimationModule::isRandom()
+	{
+		return loopMode == TextureAnimationMode::Loop && minFps != maxFps;
+	}
+
+	NativeTextureAnimationModule::NativeTextureAnimationModule() : NativeSubmodule()
+	{
+		rebuildFrames();
+	}
+
+	void NativeTextureAnimationModule::regenerateRandom()
+	{
+		if (loopMode != TextureAnimationMode::Loop || !isInitialized)
+			return;
+
+		startFramesHandle = arena->acquire(this, 0, sizeof(float));
+		if (isRandom())
+			randHandle = arena->acquire(ParticleAttribute::Random7);
+	}
+
+	void NativeTextureAnimationModule::rebuildFrames()
+	{
+		// Columns run along x, rows along y, and frames are numbered row by row.
+		const int32_t width = (int32_t)textureSize.x > 0 ? (int32_t)textureSize.x : 1;
+		const int32_t height = (int32_t)textureSize.y > 0 ? (int32_t)textureSize.y : 1;
+		frames.setGrid(width, height, sheetRows, sheetColumns);
+	}
 
 	void Particles::NativeTextureAnimationModule::onInitialize(const int32_t particleArrayLength)
 	{
 		particlesLength = particleArrayLength;
 		isInitialized = true;
+
+		regenerateRandom();
 	}
 
-	void NativeTextureAnimationModule::onParticlesActivated(const int32_t* const particleIndexArr, Particle* const particlesArrPtr, const int32_t length) { }
+	void NativeTextureAnimationModule::onParticlesActivated(ParticleBuffer* const buffer, RandomStream& random, const int32_t start, const int32_t end)
+	{
+		if (loopMode != TextureAnimationMode::Loop)
+			return;
 
-	void NativeTextureAnimationModule::onUpdate(float deltaTime, Particle* const particleArrPtr, const int32_t length)
+		// Start frames are stored as a fractional phase, so a random start also offsets the first frame's duration.
+		float* const startFrames = arena->get<float>(startFramesHandle);
+		const int32_t* const __restrict ids = buffer->id;
+		if (randomStartFrame) {
+			random.fillIndexed(startFrames, &ids[start], end - start, 0.0f, (float)frames.getFrameCount());
+		} else {
+			for (int32_t i = start; i < end; i++) {
+				startFrames[ids[i]] = 0.0f;
+			}
+		}
+	}
+
+	void NativeTextureAnimationModule::onUpdate(const float deltaTime, ParticleBuffer* const buffer, const int32_t start, const int32_t end)
 	{
-		int totalFrames = sheetRows * sheetColumns;
-		int frameSize = (int)textureSize.x / sheetRows;
+		const Int4* const __restrict rects = frames.getRects();
+		const int32_t* const __restrict ids = buffer->id;
+		const float* const __restrict life = buffer->life;
+		const float* const __restrict timeAlive = buffer->timeAlive;
+		int32_t* const __restrict sourceRectX = buffer->sourceRectX;
+		int32_t* const __restrict sourceRectY = buffer->sourceRectY;
+		int32_t* const __restrict sourceRectWidth = buffer->sourceRectWidth;
+		int32_t* const __restrict sourceRectHeight = buffer->sourceRectHeight;
+		const int32_t totalFrames = frames.getFrameCount();
+		const int32_t lastFrame = totalFrames - 1;
 		switch (loopMode) {
 			case TextureAnimationMode::Life: {
+				const float frameCount = (float)totalFrames;
 				#pragma omp simd
-				for (size_t i = 0; i < length; i++) {
-					Particle* particle = &particleArrPtr[i];
-					int frame = (int)ParticleMath::between(0.0f, totalFrames, particle->timeAlive / particle->initialLife);
-					int frameX = floor(frame % sheetRows);
-					int frameY = floor(frame / sheetRows);
-					particle->sourceRectangle = Int4(
-						frameX * frameSize,
-						frameY * frameSize,
-						frameSize,
-						frameSize);
+				for (int32_t i = start; i < end; i++) {
+					int32_t frame = (int32_t)(life[i] * frameCount);
+					frame = frame < lastFrame ? frame : lastFrame;
+					frame = frame > 0 ? frame : 0;
+					const Int4& rect = rects[frame];
+					sourceRectX[i] = rect.x;
+					sourceRectY[i] = rect.y;
+					sourceRectWidth[i] = rect.z;
+					sourceRectHeight[i] = rect.w;
 				}
 			} break;
 			case TextureAnimationMode::Loop: {
-				// TODO.
+				const float* const rand = isRandom() ? arena->get<float>(randHandle) : nullptr;
+				const float* const startFrames = arena->get<float>(startFramesHandle);
+				const float frameCount = (float)totalFrames;
+				const float invFrameCount = 1.0f / frameCount;
+				for (int32_t i = start; i < end; i++) {
+					const int32_t pId = ids[i];
+					const float fps = rand != nullptr ? ParticleMath::between(minFps, maxFps, rand[pId]) : minFps;
+					const float phase = startFrames[pId] + (timeAlive[i] * fps);
+					int32_t frame = (int32_t)(phase - (floorf(phase * invFrameCount) * frameCount));
+					frame = frame < lastFrame ? frame : lastFrame;
+					frame = frame > 0 ? frame : 0;
+					const Int4& rect = rects[frame];
+					sourceRectX[i] = rect.x;
+					sourceRectY[i] = rect.y;
+					sourceRectWidth[i] = rect.z;
+					sourceRectHeight[i] = rect.w;
+				}
 			} break;
 		}
 	}
 
+	const uint32_t NativeTextureAnimationModule::getReadStreams()
+	{
+		if (loopMode == TextureAnimationMode::Loop)
+			return ParticleStream::Id | ParticleStream::Life;
+
+		return ParticleStream::Life;
+	}
+
+	const uint32_t NativeTextureAnimationModule::getWriteStreams()
+	{
+		return ParticleStream::SourceRectangle;
+	}
+
+	const uint32_t NativeTextureAnimationModule::getAttributes()
+	{
+		return isRandom() ? ParticleAttribute::Random7 : ParticleAttribute::None;
+	}
+
 	const bool NativeTextureAnimationModule::isValid()
 	{
 		return false;
@@ -47,13 +134,34 @@ namespace Particles {
 
 	void NativeTextureAnimationModule::setOverLifetime(const int32_t sheetRows, const int32_t sheetColumns)
 	{
+		if (sheetRows <= 0 || sheetColumns <= 0)
+			throw std::invalid_argument("Sheet dimensions must be positive!");
+
+		loopMode = TextureAnimationMode::Life;
 		this->sheetRows = sheetRows;
 		this->sheetColumns = sheetColumns;
+		rebuildFrames();
+	}
+
+	void NativeTextureAnimationModule::setLoop(const int32_t sheetRows, const int32_t sheetColumns, const float minFps, const float maxFps, const bool randomStartFrame)
+	{
+		if (sheetRows <= 0 || sheetColumns <= 0)
+			throw std::invalid_argument("Sheet dimensions must be positive!");
+
+		loopMode = TextureAnimationMode::Loop;
+		this->sheetRows = sheetRows;
+		this->sheetColumns = sheetColumns;
+		this->minFps = minFps;
+		this->maxFps = maxFps;
+		this->randomStartFrame = randomStartFrame;
+		rebuildFrames();
+		regenerateRandom();
 	}
 
 	void NativeTextureAnimationModule::setTextureSize(const Vector2 textureSize)
 	{
 		this->textureSize = textureSize;
+		rebuildFrames();
 	}
 
 	NativeTextureAnimationModule::~NativeTextureAnimationModule() { }
@@ -73,4 +181,9 @@ namespace Particles {
 		modulePtr->setOverLifetime(sheetRows, sheetColumns);
 	}
 
+	LIB_API(void) nativeModule_TextureAnimationModule_SetLoop(NativeTextureAnimationModule* const modulePtr, int32_t sheetRows, int32_t sheetColumns, float minFps, float maxFps, bool randomStartFrame)
+	{
+		modulePtr->setLoop(sheetRows, sheetColumns, minFps, maxFps, randomStartFrame);
+	}
+
 }
\ No newline at end of file
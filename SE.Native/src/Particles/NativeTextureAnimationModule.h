@@ -6,6 +6,7 @@
 #include "src/SE.Native.h"
 #include "Particle.h"
 #include "NativeSubmodule.h"
+#include "FrameTable.h"
 #include "src/Utility.h"
 
 namespace Particles {
@@ -21,15 +22,33 @@ namespace Particles {
 		int32_t sheetColumns = 1;
 		Vector2 textureSize = Vector2(512, 512);
 
+		// Frame rects, rebuilt whenever the sheet or texture changes, so the update is a lookup per particle.
+		FrameTable frames;
+
+		// Loop mode. Each particle's frame rate is drawn between minFps and maxFps.
+		float minFps = 0.0f;
+		float maxFps = 0.0f;
+		bool randomStartFrame = false;
+		int32_t randHandle = -1;
+		int32_t startFramesHandle = -1;
+
+		bool isRandom();
+		void regenerateRandom();
+		void rebuildFrames();
+
 	public:
 		NativeTextureAnimationModule();
 
 		void onInitialize(const int32_t particleArrayLength) override;
-		void onParticlesActivated(const int32_t* const particleIndexArr, Particle* const particlesArrPtr, const int32_t length) override;
-		void onUpdate(float deltaTime, Particle* const particleArrPtr, const int32_t length) override;
+		void onParticlesActivated(ParticleBuffer* const buffer, RandomStream& random, const int32_t start, const int32_t end) override;
+		void onUpdate(const float deltaTime, ParticleBuffer* const buffer, const int32_t start, const int32_t end) override;
+		const uint32_t getReadStreams() override;
+		const uint32_t getWriteStreams() override;
+		const uint32_t getAttributes() override;
 		const bool isValid() override;
 
 		void setOverLifetime(const int32_t sheetRows, const int32_t sheetColumns);
+		void setLoop(const int32_t sheetRows, const int32_t sheetColumns, const float minFps, const float maxFps, const bool randomStartFrame);
 		void setTextureSize(const Vector2 textureSize);
 
 		~NativeTextureAnimationModule() override;
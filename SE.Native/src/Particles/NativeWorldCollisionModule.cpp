@@ -0,0 +1,330 @@
+#include "NativeWorldCollisionModule.h"
+#include "ParticleMath.h"
+#include "Particle.h"
+#include "src/Utility.h"
+#include <stdexcept>
+#include <math.h>
+
+namespace Particles {
+
+	namespace {
+		const float FAR_AWAY = 1.0e20f;
+
+		// Squared distance transform of one row or column (Felzenszwalb and Huttenlocher). 'values' is 0
+		// at features and FAR_AWAY elsewhere on input, and the squared distance to the nearest feature on
+		// output. 'stride' steps between elements. The rest are scratch of at least length + 1.
+		void transformLine(float* const values, const int32_t length, const int32_t stride, float* const line, int32_t* const parabolas, float* const bounds)
+		{
+			for (int32_t i = 0; i < length; i++) {
+				line[i] = values[i * stride];
+			}
+
+			int32_t count = 0;
+			parabolas[0] = 0;
+			bounds[0] = -FAR_AWAY;
+			bounds[1] = FAR_AWAY;
+			for (int32_t q = 1; q < length; q++) {
+				float s;
+				while (true) {
+					const int32_t p = parabolas[count];
+					s = ((line[q] + (float)(q * q)) - (line[p] + (float)(p * p))) / (float)(2 * (q - p));
+					if (s > bounds[count] || count == 0)
+						break;
+					count--;
+				}
+				if (s <= bounds[count]) {
+					parabolas[0] = q;
+					bounds[0] = -FAR_AWAY;
+					bounds[1] = FAR_AWAY;
+					continue;
+				}
+				count++;
+				parabolas[count] = q;
+				bounds[count] = s;
+				bounds[count + 1] = FAR_AWAY;
+			}
+
+			count = 0;
+			for (int32_t q = 0; q < length; q++) {
+				while (bounds[count + 1] < (float)q) {
+					count++;
+				}
+				const int32_t p = parabolas[count];
+				const float offset = (float)(q - p);
+				values[q * stride] = (offset * offset) + line[p];
+			}
+		}
+
+		// Squared distance, in cells, from every cell to the nearest one where 'isFeature' holds.
+		void transform(const uint8_t* const solid, const bool featureIsSolid, const int32_t columns, const int32_t rows, std::vector<float>& out)
+		{
+			const int32_t cellCount = columns * rows;
+			out.resize(cellCount);
+			for (int32_t i = 0; i < cellCount; i++) {
+				out[i] = ((solid[i] != 0) == featureIsSolid) ? 0.0f : FAR_AWAY;
+			}
+
+			const int32_t longest = (columns > rows ? columns : rows) + 1;
+			std::vector<float> line(longest);
+			std::vector<int32_t> parabolas(longest);
+			std::vector<float> bounds(longest + 1);
+			for (int32_t row = 0; row < rows; row++) {
+				transformLine(&out[row * columns], columns, 1, line.data(), parabolas.data(), bounds.data());
+			}
+			for (int32_t column = 0; column < columns; column++) {
+				transformLine(&out[column], rows, columns, line.data(), parabolas.data(), bounds.data());
+			}
+		}
+	}
+
+	NativeWorldCollisionModule::NativeWorldCollisionModule() : NativeSubmodule() { }
+
+	bool NativeWorldCollisionModule::hasGrid()
+	{
+		return columns > 0 && rows > 0;
+	}
+
+	void NativeWorldCollisionModule::onInitialize(const int32_t particleArrayLength)
+	{
+		particlesLength = particleArrayLength;
+		isInitialized = true;
+	}
+
+	void NativeWorldCollisionModule::onUpdate(const float deltaTime, ParticleBuffer* const buffer, const int32_t start, const int32_t end)
+	{
+		if (!hasGrid())
+			return;
+
+		const float* const __restrict distances = field.data();
+		float* const __restrict positionX = buffer->positionX;
+		float* const __restrict positionY = buffer->positionY;
+		float* const __restrict directionX = buffer->directionX;
+		float* const __restrict directionY = buffer->directionY;
+		float* const __restrict speed = buffer->speed;
+		const float* const __restrict initialLife = buffer->initialLife;
+		float* const __restrict timeAlive = buffer->timeAlive;
+		float* const __restrict life = buffer->life;
+		const float inverseCellSize = 1.0f / cellSize;
+		const float lastColumn = (float)(columns - 1);
+		const float lastRow = (float)(rows - 1);
+		const int32_t gridColumns = columns;
+		const float originX = origin.x, originY = origin.y;
+		const float contact = radius;
+		const float bounce = restitution;
+		const float slide = 1.0f - friction;
+		const bool kill = response == CollisionResponse::Kill;
+
+		// The field is sampled a block at a time, then one branch-free pass per response applies the hits.
+		const int32_t blockSize = 256;
+		float hit[blockSize], penetration[blockSize], normalX[blockSize], normalY[blockSize];
+		for (int32_t blockStart = start; blockStart < end; blockStart += blockSize) {
+			const int32_t count = (end - blockStart) < blockSize ? (end - blockStart) : blockSize;
+
+			#pragma omp simd
+			for (int32_t j = 0; j < count; j++) {
+				const int32_t i = blockStart + j;
+
+				// Grid coordinates relative to cell centers, clamped so the half cell along the border
+				// samples the outermost cells.
+				const float gridX = ((positionX[i] - originX) * inverseCellSize) - 0.5f;
+				const float gridY = ((positionY[i] - originY) * inverseCellSize) - 0.5f;
+				const float inGrid = (gridX >= -0.5f && gridX <= lastColumn + 0.5f && gridY >= -0.5f && gridY <= lastRow + 0.5f) ? 1.0f : 0.0f;
+				const float clampedX = gridX < 0.0f ? 0.0f : (gridX > lastColumn ? lastColumn : gridX);
+				const float clampedY = gridY < 0.0f ? 0.0f : (gridY > lastRow ? lastRow : gridY);
+				const int32_t column = (int32_t)clampedX;
+				const int32_t row = (int32_t)clampedY;
+				const int32_t nextColumn = (float)column < lastColumn ? column + 1 : column;
+				const int32_t nextRow = (float)row < lastRow ? row + 1 : row;
+				const float weightX = clampedX - (float)column;
+				const float weightY = clampedY - (float)row;
+
+				const float d00 = distances[(row * gridColumns) + column];
+				const float d10 = distances[(row * gridColumns) + nextColumn];
+				const float d01 = distances[(nextRow * gridColumns) + column];
+				const float d11 = distances[(nextRow * gridColumns) + nextColumn];
+				const float top = d00 + ((d10 - d00) * weightX);
+				const float bottom = d01 + ((d11 - d01) * weightX);
+				const float distance = top + ((bottom - top) * weightY);
+
+				// The bilinear gradient points away from walls. Where it vanishes the particle backs off
+				// the way it came.
+				const float gradientX = (d10 - d00) + (((d11 - d01) - (d10 - d00)) * weightY);
+				const float gradientY = (d01 - d00) + (((d11 - d10) - (d01 - d00)) * weightX);
+				const float gradientLength = sqrtf((gradientX * gradientX) + (gradientY * gradientY));
+				const float inverseGradient = 1.0f / (gradientLength > 0.0f ? gradientLength : 1.0f);
+				const float flat = gradientLength > 0.0f ? 0.0f : 1.0f;
+				const float isHit = inGrid * (distance < contact ? 1.0f : 0.0f);
+				hit[j] = isHit;
+				penetration[j] = (contact - distance) * isHit;
+				normalX[j] = (gradientX * inverseGradient) - (directionX[i] * flat);
+				normalY[j] = (gradientY * inverseGradient) - (directionY[i] * flat);
+			}
+
+			if (kill) {
+				#pragma omp simd
+				for (int32_t j = 0; j < count; j++) {
+					const int32_t i = blockStart + j;
+					ParticleMath::kill(hit[j] > 0.0f, initialLife[i], &timeAlive[i], &life[i]);
+				}
+				continue;
+			}
+
+			#pragma omp simd
+			for (int32_t j = 0; j < count; j++) {
+				const int32_t i = blockStart + j;
+				const float nx = normalX[j];
+				const float ny = normalY[j];
+				positionX[i] += nx * penetration[j];
+				positionY[i] += ny * penetration[j];
+
+				// Only velocity into the wall is reflected. The part along it is kept, less friction.
+				const float velocityX = directionX[i] * speed[i];
+				const float velocityY = directionY[i] * speed[i];
+				const float normalVelocity = (velocityX * nx) + (velocityY * ny);
+				const float approaching = hit[j] * (normalVelocity < 0.0f ? 1.0f : 0.0f);
+				const float tangentX = velocityX - (normalVelocity * nx);
+				const float tangentY = velocityY - (normalVelocity * ny);
+				const float responseX = (tangentX * slide) - (nx * normalVelocity * bounce);
+				const float responseY = (tangentY * slide) - (ny * normalVelocity * bounce);
+				const float newVelocityX = velocityX + ((responseX - velocityX) * approaching);
+				const float newVelocityY = velocityY + ((responseY - velocityY) * approaching);
+				ParticleMath::setVelocity(newVelocityX, newVelocityY, &directionX[i], &directionY[i], &speed[i]);
+			}
+		}
+	}
+
+	const uint32_t NativeWorldCollisionModule::getReadStreams()
+	{
+		if (response == CollisionResponse::Kill)
+			return ParticleStream::Position | ParticleStream::Direction | ParticleStream::Life;
+
+		return ParticleStream::Position | ParticleStream::Direction | ParticleStream::Speed;
+	}
+
+	const uint32_t NativeWorldCollisionModule::getWriteStreams()
+	{
+		if (!hasGrid())
+			return ParticleStream::None;
+		if (response == CollisionResponse::Kill)
+			return ParticleStream::Life;
+
+		return ParticleStream::Position | ParticleStream::Direction | ParticleStream::Speed;
+	}
+
+	const bool NativeWorldCollisionModule::isValid()
+	{
+		return false; // ???
+	}
+
+	void NativeWorldCollisionModule::setGridBounds(const int32_t columns, const int32_t rows, const Vector2 origin, const float cellSize)
+	{
+		if (columns <= 0 || rows <= 0)
+			throw std::invalid_argument("Grid must have at least one cell!");
+		if ((int64_t)columns * rows > INT32_MAX)
+			throw std::invalid_argument("Grid is too large!");
+		if (!(cellSize > 0.0f))
+			throw std::invalid_argument("Cell size must be positive!");
+
+		this->columns = columns;
+		this->rows = rows;
+		this->origin = origin;
+		this->cellSize = cellSize;
+	}
+
+	void NativeWorldCollisionModule::setDistanceField(const float* const distances, const int32_t columns, const int32_t rows, const Vector2 origin, const float cellSize)
+	{
+		setGridBounds(columns, rows, origin, cellSize);
+		field.assign(distances, distances + (columns * rows));
+	}
+
+	void NativeWorldCollisionModule::setOccupancy(const uint8_t* const solid, const int32_t columns, const int32_t rows, const Vector2 origin, const float cellSize)
+	{
+		if (columns <= 0 || rows <= 0 || (int64_t)columns * rows * OCCUPANCY_SUBDIVISION * OCCUPANCY_SUBDIVISION > INT32_MAX)
+			throw std::invalid_argument("Grid must have at least one cell and fit in memory!");
+
+		// Bilinear sampling rounds corners off by about half a cell, so tiles are split before baking.
+		const int32_t fineColumns = columns * OCCUPANCY_SUBDIVISION;
+		const int32_t fineRows = rows * OCCUPANCY_SUBDIVISION;
+		const float fineCellSize = cellSize / (float)OCCUPANCY_SUBDIVISION;
+		setGridBounds(fineColumns, fineRows, origin, fineCellSize);
+		std::vector<uint8_t> fine((size_t)fineColumns * fineRows);
+		for (int32_t row = 0; row < fineRows; row++) {
+			for (int32_t column = 0; column < fineColumns; column++) {
+				fine[((size_t)row * fineColumns) + column] = solid[((row / OCCUPANCY_SUBDIVISION) * columns) + (column / OCCUPANCY_SUBDIVISION)];
+			}
+		}
+
+		// Distances between cell centers, less half a cell, so the field crosses 0 on the tile edges.
+		std::vector<float> toSolid;
+		transform(fine.data(), true, fineColumns, fineRows, toSolid);
+		transform(fine.data(), false, fineColumns, fineRows, field);
+		const int32_t cellCount = fineColumns * fineRows;
+		for (int32_t i = 0; i < cellCount; i++) {
+			field[i] = fine[i] != 0
+				? -(sqrtf(field[i]) - 0.5f) * fineCellSize
+				: (sqrtf(toSolid[i]) - 0.5f) * fineCellSize;
+		}
+	}
+
+	void NativeWorldCollisionModule::clearGrid()
+	{
+		columns = 0;
+		rows = 0;
+		std::vector<float>().swap(field);
+	}
+
+	void NativeWorldCollisionModule::setBounce(const float restitution, const float friction)
+	{
+		response = CollisionResponse::Bounce;
+		this->restitution = restitution > 0.0f ? restitution : 0.0f;
+		this->friction = friction < 0.0f ? 0.0f : (friction > 1.0f ? 1.0f : friction);
+	}
+
+	void NativeWorldCollisionModule::setKill()
+	{
+		response = CollisionResponse::Kill;
+	}
+
+	void NativeWorldCollisionModule::setRadius(const float radius)
+	{
+		this->radius = radius > 0.0f ? radius : 0.0f;
+	}
+
+	NativeWorldCollisionModule::~NativeWorldCollisionModule() { }
+
+	LIB_API(NativeWorldCollisionModule*) nativeModule_WorldCollisionModule_Ctor()
+	{
+		return new NativeWorldCollisionModule();
+	}
+
+	LIB_API(void) nativeModule_WorldCollisionModule_SetDistanceField(NativeWorldCollisionModule* const modulePtr, const float* const distanceArrPtr, const int32_t columns, const int32_t rows, const Vector2 origin, const float cellSize)
+	{
+		modulePtr->setDistanceField(distanceArrPtr, columns, rows, origin, cellSize);
+	}
+
+	LIB_API(void) nativeModule_WorldCollisionModule_SetOccupancy(NativeWorldCollisionModule* const modulePtr, const uint8_t* const solidArrPtr, const int32_t columns, const int32_t rows, const Vector2 origin, const float cellSize)
+	{
+		modulePtr->setOccupancy(solidArrPtr, columns, rows, origin, cellSize);
+	}
+
+	LIB_API(void) nativeModule_WorldCollisionModule_ClearGrid(NativeWorldCollisionModule* const modulePtr)
+	{
+		modulePtr->clearGrid();
+	}
+
+	LIB_API(void) nativeModule_WorldCollisionModule_SetBounce(NativeWorldCollisionModule* const modulePtr, const float restitution, const float friction)
+	{
+		modulePtr->setBounce(restitution, friction);
+	}
+
+	LIB_API(void) nativeModule_WorldCollisionModule_SetKill(NativeWorldCollisionModule* const modulePtr)
+	{
+		modulePtr->setKill();
+	}
+
+	LIB_API(void) nativeModule_WorldCollisionModule_SetRadius(NativeWorldCollisionModule* const modulePtr, const float radius)
+	{
+		modulePtr->setRadius(radius);
+	}
+
+}
\ No newline at end of file
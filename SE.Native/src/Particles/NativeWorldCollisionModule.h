@@ -0,0 +1,73 @@
+#pragma once
+
+#ifndef NATIVEWORLDCOLLISIONMODULE_H
+#define NATIVEWORLDCOLLISIONMODULE_H
+
+#include "src/SE.Native.h"
+#include "Particle.h"
+#include "NativeSubmodule.h"
+#include "src/Utility.h"
+#include <vector>
+
+namespace Particles {
+
+	namespace CollisionResponse {
+		// Bounce reflects the velocity into the wall, scaled by restitution, and scales the velocity along
+		// it by 1 - friction. Kill ends the particle's life.
+		enum Response : int32_t { Bounce, Kill };
+	}
+
+	// Collides particles with static level geometry given as a signed distance field: distances in world
+	// units at the centers of a grid of square cells, negative inside walls. The field is sampled
+	// bilinearly, and a particle closer than its radius to a wall is pushed out along the field's
+	// gradient. Outside the grid there is nothing to hit. Collisions are tested at the end of each
+	// step, so particles moving more than a wall's thickness per frame can pass through it.
+	class NativeWorldCollisionModule final : NativeSubmodule {
+	public:
+		// Occupancy grids are baked at this many field cells per tile along each axis.
+		static const int32_t OCCUPANCY_SUBDIVISION = 4;
+
+	private:
+		int particlesLength;
+		std::vector<float> field;
+		int32_t columns = 0;
+		int32_t rows = 0;
+		Vector2 origin = Vector2(0.0f, 0.0f);
+		float cellSize = 1.0f;
+
+		CollisionResponse::Response response = CollisionResponse::Bounce;
+		float restitution = 0.5f;
+		float friction = 0.0f;
+		float radius = 0.0f;
+
+		bool hasGrid();
+		void setGridBounds(const int32_t columns, const int32_t rows, const Vector2 origin, const float cellSize);
+
+	public:
+		NativeWorldCollisionModule();
+
+		void onInitialize(const int32_t particleArrayLength) override;
+		void onUpdate(const float deltaTime, ParticleBuffer* const buffer, const int32_t start, const int32_t end) override;
+		const uint32_t getReadStreams() override;
+		const uint32_t getWriteStreams() override;
+		const bool isValid() override;
+
+		// Cell (column, row) is distances[(row * columns) + column]. Origin is the top left corner of the grid.
+		void setDistanceField(const float* const distances, const int32_t columns, const int32_t rows, const Vector2 origin, const float cellSize);
+
+		// Tile occupancy, nonzero for solid cells, baked into an exact distance field. For tilemaps, upload
+		// once per level with the tile size as the cell size. Same layout as setDistanceField().
+		void setOccupancy(const uint8_t* const solid, const int32_t columns, const int32_t rows, const Vector2 origin, const float cellSize);
+		void clearGrid();
+
+		void setBounce(const float restitution, const float friction);
+		void setKill();
+
+		// Distance from a wall at which particles collide.
+		void setRadius(const float radius);
+
+		~NativeWorldCollisionModule() override;
+	};
+}
+
+#endif
\ No newline at end of file
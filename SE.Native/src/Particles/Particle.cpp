@@ -21,10 +21,14 @@ namespace Particles {
 
     ParticleColor ParticleColor::Lerp(ParticleColor value1, ParticleColor value2, float amount)
     {
+        // Lerps the stored bytes directly. Going through the (h, s, l, a) constructor would rescale them as degrees/percent.
         amount = ParticleMath::clamp(amount, 0, 1);
-        return ParticleColor(ParticleMath::lerpByte(value1.getHueByte(), value2.getHueByte(), amount),
-            ParticleMath::lerpByte(value1.getSaturationByte(), value2.getSaturationByte(), amount),
-            ParticleMath::lerpByte(value1.getLightnessByte(), value2.getLightnessByte(), amount),
-            ParticleMath::lerpByte(value1.getAlphaByte(), value2.getAlphaByte(), amount));
+        ParticleColor color;
+        color.packedValue = 0;
+        color.setHueByte(ParticleMath::lerpByte(value1.getHueByte(), value2.getHueByte(), amount));
+        color.setSaturationByte(ParticleMath::lerpByte(value1.getSaturationByte(), value2.getSaturationByte(), amount));
+        color.setLightnessByte(ParticleMath::lerpByte(value1.getLightnessByte(), value2.getLightnessByte(), amount));
+        color.setAlphaByte(ParticleMath::lerpByte(value1.getAlphaByte(), value2.getAlphaByte(), amount));
+        return color;
     }
 }
\ No newline at end of file
@@ -0,0 +1,309 @@
+#include "ParticleBuffer.h"
+#include <string.h>
+
+namespace Particles {
+
+	ParticleBuffer::ParticleBuffer() { }
+
+	const int32_t ParticleBuffer::getCapacity()
+	{
+		return capacity;
+	}
+
+	void ParticleBuffer::resize(const int32_t newCapacity)
+	{
+		if (newCapacity <= capacity)
+			return;
+
+		// Every stream holds 4-byte elements, padded so the next stream starts on a cache line.
+		const size_t streamSize = AlignedMemory::alignSize((size_t)newCapacity * 4);
+		uint8_t* newMemory = (uint8_t*)AlignedMemory::allocate(streamSize * STREAM_COUNT);
+		memset(newMemory, 0, streamSize * STREAM_COUNT);
+
+		// Preserve existing contents, stream by stream.
+		if (memory != nullptr) {
+			const size_t oldStreamSize = AlignedMemory::alignSize((size_t)capacity * 4);
+			for (int32_t i = 0; i < STREAM_COUNT; i++) {
+				memcpy(newMemory + (i * streamSize), (uint8_t*)memory + (i * oldStreamSize), (size_t)capacity * 4);
+			}
+			AlignedMemory::free(memory);
+		}
+
+		memory = newMemory;
+		capacity = newCapacity;
+
+		uint8_t* ptr = newMemory;
+		positionX = (float*)ptr; ptr += streamSize;
+		positionY = (float*)ptr; ptr += streamSize;
+		scaleX = (float*)ptr; ptr += streamSize;
+		scaleY = (float*)ptr; ptr += streamSize;
+		spriteRotation = (float*)ptr; ptr += streamSize;
+		color = (ParticleColor*)ptr; ptr += streamSize;
+		id = (int32_t*)ptr; ptr += streamSize;
+		directionX = (float*)ptr; ptr += streamSize;
+		directionY = (float*)ptr; ptr += streamSize;
+		mass = (float*)ptr; ptr += streamSize;
+		speed = (float*)ptr; ptr += streamSize;
+		initialLife = (float*)ptr; ptr += streamSize;
+		timeAlive = (float*)ptr; ptr += streamSize;
+		layerDepth = (float*)ptr; ptr += streamSize;
+		sourceRectX = (int32_t*)ptr; ptr += streamSize;
+		sourceRectY = (int32_t*)ptr; ptr += streamSize;
+		sourceRectWidth = (int32_t*)ptr; ptr += streamSize;
+		sourceRectHeight = (int32_t*)ptr; ptr += streamSize;
+		life = (float*)ptr;
+	}
+
+	void ParticleBuffer::readFrom(const Particle* const particleArrPtr, const int32_t start, const int32_t end, const uint32_t streams)
+	{
+		const Particle* const __restrict src = particleArrPtr;
+		if (streams & ParticleStream::Position) {
+			for (int32_t i = start; i < end; i++) {
+				positionX[i] = src[i].position.x;
+				positionY[i] = src[i].position.y;
+			}
+		}
+		if (streams & ParticleStream::Scale) {
+			for (int32_t i = start; i < end; i++) {
+				scaleX[i] = src[i].scale.x;
+				scaleY[i] = src[i].scale.y;
+			}
+		}
+		if (streams & ParticleStream::SpriteRotation) {
+			for (int32_t i = start; i < end; i++) {
+				spriteRotation[i] = src[i].spriteRotation;
+			}
+		}
+		if (streams & ParticleStream::Color) {
+			for (int32_t i = start; i < end; i++) {
+				color[i] = src[i].color;
+			}
+		}
+		if (streams & ParticleStream::Id) {
+			for (int32_t i = start; i < end; i++) {
+				id[i] = src[i].id;
+			}
+		}
+		if (streams & ParticleStream::Direction) {
+			for (int32_t i = start; i < end; i++) {
+				directionX[i] = src[i].direction.x;
+				directionY[i] = src[i].direction.y;
+			}
+		}
+		if (streams & ParticleStream::Mass) {
+			for (int32_t i = start; i < end; i++) {
+				mass[i] = src[i].mass;
+			}
+		}
+		if (streams & ParticleStream::Speed) {
+			for (int32_t i = start; i < end; i++) {
+				speed[i] = src[i].speed;
+			}
+		}
+		if (streams & ParticleStream::Life) {
+			for (int32_t i = start; i < end; i++) {
+				initialLife[i] = src[i].initialLife;
+				timeAlive[i] = src[i].timeAlive;
+			}
+		}
+		if (streams & ParticleStream::LayerDepth) {
+			for (int32_t i = start; i < end; i++) {
+				layerDepth[i] = src[i].layerDepth;
+			}
+		}
+		if (streams & ParticleStream::SourceRectangle) {
+			for (int32_t i = start; i < end; i++) {
+				sourceRectX[i] = src[i].sourceRectangle.x;
+				sourceRectY[i] = src[i].sourceRectangle.y;
+				sourceRectWidth[i] = src[i].sourceRectangle.z;
+				sourceRectHeight[i] = src[i].sourceRectangle.w;
+			}
+		}
+	}
+
+	void ParticleBuffer::readFrom(const Particle* const particleArrPtr, const int32_t* const particleIndexArr, const int32_t length, const uint32_t streams)
+	{
+		// Gathers the indexed particles into [0, length).
+		const Particle* const __restrict src = particleArrPtr;
+		for (int32_t i = 0; i < length; i++) {
+			const Particle* particle = &src[particleIndexArr[i]];
+			if (streams & ParticleStream::Position) {
+				positionX[i] = particle->position.x;
+				positionY[i] = particle->position.y;
+			}
+			if (streams & ParticleStream::Scale) {
+				scaleX[i] = particle->scale.x;
+				scaleY[i] = particle->scale.y;
+			}
+			if (streams & ParticleStream::SpriteRotation)
+				spriteRotation[i] = particle->spriteRotation;
+			if (streams & ParticleStream::Color)
+				color[i] = particle->color;
+			if (streams & ParticleStream::Id)
+				id[i] = particle->id;
+			if (streams & ParticleStream::Direction) {
+				directionX[i] = particle->direction.x;
+				directionY[i] = particle->direction.y;
+			}
+			if (streams & ParticleStream::Mass)
+				mass[i] = particle->mass;
+			if (streams & ParticleStream::Speed)
+				speed[i] = particle->speed;
+			if (streams & ParticleStream::Life) {
+				initialLife[i] = particle->initialLife;
+				timeAlive[i] = particle->timeAlive;
+			}
+			if (streams & ParticleStream::LayerDepth)
+				layerDepth[i] = particle->layerDepth;
+			if (streams & ParticleStream::SourceRectangle) {
+				sourceRectX[i] = particle->sourceRectangle.x;
+				sourceRectY[i] = particle->sourceRectangle.y;
+				sourceRectWidth[i] = particle->sourceRectangle.z;
+				sourceRectHeight[i] = particle->sourceRectangle.w;
+			}
+		}
+	}
+
+	void ParticleBuffer::writeTo(Particle* const particleArrPtr, const int32_t start, const int32_t end, const uint32_t streams)
+	{
+		Particle* const __restrict dst = particleArrPtr;
+		if (streams & ParticleStream::Position) {
+			for (int32_t i = start; i < end; i++) {
+				dst[i].position.x = positionX[i];
+				dst[i].position.y = positionY[i];
+			}
+		}
+		if (streams & ParticleStream::Scale) {
+			for (int32_t i = start; i < end; i++) {
+				dst[i].scale.x = scaleX[i];
+				dst[i].scale.y = scaleY[i];
+			}
+		}
+		if (streams & ParticleStream::SpriteRotation) {
+			for (int32_t i = start; i < end; i++) {
+				dst[i].spriteRotation = spriteRotation[i];
+			}
+		}
+		if (streams & ParticleStream::Color) {
+			for (int32_t i = start; i < end; i++) {
+				dst[i].color = color[i];
+			}
+		}
+		if (streams & ParticleStream::Id) {
+			for (int32_t i = start; i < end; i++) {
+				dst[i].id = id[i];
+			}
+		}
+		if (streams & ParticleStream::Direction) {
+			for (int32_t i = start; i < end; i++) {
+				dst[i].direction.x = directionX[i];
+				dst[i].direction.y = directionY[i];
+			}
+		}
+		if (streams & ParticleStream::Mass) {
+			for (int32_t i = start; i < end; i++) {
+				dst[i].mass = mass[i];
+			}
+		}
+		if (streams & ParticleStream::Speed) {
+			for (int32_t i = start; i < end; i++) {
+				dst[i].speed = speed[i];
+			}
+		}
+		if (streams & ParticleStream::Life) {
+			for (int32_t i = start; i < end; i++) {
+				dst[i].initialLife = initialLife[i];
+				dst[i].timeAlive = timeAlive[i];
+			}
+		}
+		if (streams & ParticleStream::LayerDepth) {
+			for (int32_t i = start; i < end; i++) {
+				dst[i].layerDepth = layerDepth[i];
+			}
+		}
+		if (streams & ParticleStream::SourceRectangle) {
+			for (int32_t i = start; i < end; i++) {
+				dst[i].sourceRectangle = Int4(sourceRectX[i], sourceRectY[i], sourceRectWidth[i], sourceRectHeight[i]);
+			}
+		}
+	}
+
+	void ParticleBuffer::writeTo(Particle* const particleArrPtr, const int32_t* const particleIndexArr, const int32_t length, const uint32_t streams)
+	{
+		// Scatters [0, length) back to the indexed particles.
+		Particle* const __restrict dst = particleArrPtr;
+		for (int32_t i = 0; i < length; i++) {
+			Particle* particle = &dst[particleIndexArr[i]];
+			if (streams & ParticleStream::Position)
+				particle->position = Vector2(positionX[i], positionY[i]);
+			if (streams & ParticleStream::Scale)
+				particle->scale = Vector2(scaleX[i], scaleY[i]);
+			if (streams & ParticleStream::SpriteRotation)
+				particle->spriteRotation = spriteRotation[i];
+			if (streams & ParticleStream::Color)
+				particle->color = color[i];
+			if (streams & ParticleStream::Id)
+				particle->id = id[i];
+			if (streams & ParticleStream::Direction)
+				particle->direction = Vector2(directionX[i], directionY[i]);
+			if (streams & ParticleStream::Mass)
+				particle->mass = mass[i];
+			if (streams & ParticleStream::Speed)
+				particle->speed = speed[i];
+			if (streams & ParticleStream::Life) {
+				particle->initialLife = initialLife[i];
+				particle->timeAlive = timeAlive[i];
+			}
+			if (streams & ParticleStream::LayerDepth)
+				particle->layerDepth = layerDepth[i];
+			if (streams & ParticleStream::SourceRectangle)
+				particle->sourceRectangle = Int4(sourceRectX[i], sourceRectY[i], sourceRectWidth[i], sourceRectHeight[i]);
+		}
+	}
+
+	void ParticleBuffer::updateLife(const int32_t start, const int32_t end)
+	{
+		const float* const __restrict alive = timeAlive;
+		const float* const __restrict initial = initialLife;
+		float* const __restrict normalized = life;
+
+		#pragma omp simd
+		for (int32_t i = start; i < end; i++) {
+			normalized[i] = alive[i] / initial[i];
+		}
+	}
+
+	void ParticleBuffer::setParticle(const int32_t index, const Particle& particle)
+	{
+		positionX[index] = particle.position.x;
+		positionY[index] = particle.position.y;
+		scaleX[index] = particle.scale.x;
+		scaleY[index] = particle.scale.y;
+		spriteRotation[index] = particle.spriteRotation;
+		color[index] = particle.color;
+		id[index] = particle.id;
+		directionX[index] = particle.direction.x;
+		directionY[index] = particle.direction.y;
+		mass[index] = particle.mass;
+		speed[index] = particle.speed;
+		initialLife[index] = particle.initialLife;
+		timeAlive[index] = particle.timeAlive;
+		layerDepth[index] = particle.layerDepth;
+		sourceRectX[index] = particle.sourceRectangle.x;
+		sourceRectY[index] = particle.sourceRectangle.y;
+		sourceRectWidth[index] = particle.sourceRectangle.z;
+		sourceRectHeight[index] = particle.sourceRectangle.w;
+		life[index] = particle.timeAlive / particle.initialLife;
+	}
+
+	uint32_t* ParticleBuffer::getStream(const int32_t index)
+	{
+		const size_t streamSize = AlignedMemory::alignSize((size_t)capacity * 4);
+		return (uint32_t*)((uint8_t*)memory + (index * streamSize));
+	}
+
+	ParticleBuffer::~ParticleBuffer()
+	{
+		AlignedMemory::free(memory);
+	}
+}
\ No newline at end of file
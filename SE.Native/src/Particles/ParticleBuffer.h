@@ -0,0 +1,87 @@
+#pragma once
+
+#ifndef PARTICLEBUFFER_H
+#define PARTICLEBUFFER_H
+
+#include "src/Utility.h"
+#include "Particle.h"
+
+namespace Particles
+{
+	// Bitmask identifying the attribute streams of a ParticleBuffer. Submodules report which
+	// streams they read and write, so the AoS bridge only moves the attributes actually used.
+	namespace ParticleStream {
+		enum Stream : uint32_t {
+			None = 0,
+			Position = 1 << 0,
+			Scale = 1 << 1,
+			SpriteRotation = 1 << 2,
+			Color = 1 << 3,
+			Id = 1 << 4,
+			Direction = 1 << 5,
+			Mass = 1 << 6,
+			Speed = 1 << 7,
+			Life = 1 << 8,			// initialLife, timeAlive and the derived normalized life.
+			LayerDepth = 1 << 9,
+			SourceRectangle = 1 << 10,
+			All = (1 << 11) - 1
+		};
+	}
+
+	// Structure-of-arrays particle storage. Every stream is 64-byte aligned and carved out of a
+	// single allocation. Element i of every stream describes the same particle.
+	class ParticleBuffer {
+	public:
+		// Every stream is 4-byte elements. Streams are laid out in declaration order below.
+		static const int32_t STREAM_COUNT = 19;
+
+		float* positionX = nullptr;
+		float* positionY = nullptr;
+		float* scaleX = nullptr;
+		float* scaleY = nullptr;
+		float* spriteRotation = nullptr;
+		ParticleColor* color = nullptr;
+		int32_t* id = nullptr;
+		float* directionX = nullptr;
+		float* directionY = nullptr;
+		float* mass = nullptr;
+		float* speed = nullptr;
+		float* initialLife = nullptr;
+		float* timeAlive = nullptr;
+		float* layerDepth = nullptr;
+		int32_t* sourceRectX = nullptr;
+		int32_t* sourceRectY = nullptr;
+		int32_t* sourceRectWidth = nullptr;
+		int32_t* sourceRectHeight = nullptr;
+
+		// Normalized age (timeAlive / initialLife), derived by updateLife().
+		float* life = nullptr;
+
+		ParticleBuffer();
+
+		const int32_t getCapacity();
+		void resize(const int32_t newCapacity);
+
+		void readFrom(const Particle* const particleArrPtr, const int32_t start, const int32_t end, const uint32_t streams);
+		void readFrom(const Particle* const particleArrPtr, const int32_t* const particleIndexArr, const int32_t length, const uint32_t streams);
+		void writeTo(Particle* const particleArrPtr, const int32_t start, const int32_t end, const uint32_t streams);
+		void writeTo(Particle* const particleArrPtr, const int32_t* const particleIndexArr, const int32_t length, const uint32_t streams);
+		void updateLife(const int32_t start, const int32_t end);
+		void setParticle(const int32_t index, const Particle& particle);
+
+		// Raw view of stream 'index' (0 is positionX, STREAM_COUNT - 1 is life), for passes that
+		// treat every stream alike.
+		uint32_t* getStream(const int32_t index);
+
+		~ParticleBuffer();
+
+	private:
+		int32_t capacity = 0;
+		void* memory = nullptr;
+
+		ParticleBuffer(const ParticleBuffer&) = delete;
+		ParticleBuffer& operator=(const ParticleBuffer&) = delete;
+	};
+}
+
+#endif
\ No newline at end of file
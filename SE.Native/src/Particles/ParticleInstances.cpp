@@ -0,0 +1,334 @@
+#include "ParticleInstances.h"
+#include "NativeModule.h"
+#include "src/Utility/ThreadPool.h"
+#include <stdexcept>
+#include <atomic>
+#include <math.h>
+
+namespace Particles {
+
+	static_assert(sizeof(ParticleInstance) == 40, "ParticleInstance must stay 40 bytes to match the vertex declaration.");
+	static_assert(sizeof(CompactParticleInstance) == 20, "CompactParticleInstance must stay 20 bytes to match the vertex declaration.");
+
+	namespace {
+		void checkTextureSize(const float textureWidth, const float textureHeight)
+		{
+			if (!(textureWidth > 0.0f) || !(textureHeight > 0.0f))
+				throw std::invalid_argument("Texture size must be positive!");
+		}
+
+		inline void writeInstance(const Particle& particle, const float invWidth, const float invHeight, ParticleInstance& instance)
+		{
+			instance.positionX = particle.position.x;
+			instance.positionY = particle.position.y;
+			instance.scaleX = particle.scale.x;
+			instance.scaleY = particle.scale.y;
+			instance.rotation = particle.spriteRotation;
+			instance.color = particle.color;
+			instance.uvX = (float)particle.sourceRectangle.x * invWidth;
+			instance.uvY = (float)particle.sourceRectangle.y * invHeight;
+			instance.uvWidth = (float)particle.sourceRectangle.z * invWidth;
+			instance.uvHeight = (float)particle.sourceRectangle.w * invHeight;
+		}
+
+		const float PI = 3.14159265358979f;
+		const float TWO_PI = 6.28318530717959f;
+
+		// Keeps rotation in the range where half floats are most precise.
+		inline float wrapAngle(const float angle)
+		{
+			return angle - (TWO_PI * floorf((angle + PI) * (1.0f / TWO_PI)));
+		}
+
+		// Converts the color field of written records in place, through a contiguous block for the kernel.
+		template<typename Instance>
+		void convertColors(Instance* const instances, const int32_t length, const InstanceColor::Format colorFormat)
+		{
+			if (colorFormat != InstanceColor::Rgba)
+				return;
+
+			const KernelTable& kernels = SimdKernels::get();
+			const int32_t blockSize = 256;
+			uint32_t colors[blockSize];
+			for (int32_t blockStart = 0; blockStart < length; blockStart += blockSize) {
+				const int32_t count = (length - blockStart) < blockSize ? (length - blockStart) : blockSize;
+				for (int32_t j = 0; j < count; j++) {
+					colors[j] = *reinterpret_cast<const uint32_t*>(&instances[blockStart + j].color);
+				}
+				kernels.toRgba(colors, colors, count);
+				for (int32_t j = 0; j < count; j++) {
+					*reinterpret_cast<uint32_t*>(&instances[blockStart + j].color) = colors[j];
+				}
+			}
+		}
+
+		// Same test as the buildVisibleMask kernels.
+		inline bool isVisible(const Particle& particle, const ViewBounds& view)
+		{
+			const float width = (float)particle.sourceRectangle.z * particle.scale.x;
+			const float height = (float)particle.sourceRectangle.w * particle.scale.y;
+			const float radius = 0.5f * sqrtf((width * width) + (height * height));
+			const float x = particle.position.x;
+			const float y = particle.position.y;
+			return !((x + radius < view.minX) || (view.maxX < x - radius)
+				|| (y + radius < view.minY) || (view.maxY < y - radius));
+		}
+	}
+
+	void ParticleInstances::write(ParticleBuffer* const particles, const int32_t start, const int32_t end,
+		const float textureWidth, const float textureHeight, ParticleInstance* const out,
+		const InstanceColor::Format colorFormat)
+	{
+		const float invWidth = 1.0f / textureWidth;
+		const float invHeight = 1.0f / textureHeight;
+		const float* const __restrict positionX = particles->positionX;
+		const float* const __restrict positionY = particles->positionY;
+		const float* const __restrict scaleX = particles->scaleX;
+		const float* const __restrict scaleY = particles->scaleY;
+		const float* const __restrict rotation = particles->spriteRotation;
+		const ParticleColor* const __restrict color = particles->color;
+		const int32_t* const __restrict rectX = particles->sourceRectX;
+		const int32_t* const __restrict rectY = particles->sourceRectY;
+		const int32_t* const __restrict rectWidth = particles->sourceRectWidth;
+		const int32_t* const __restrict rectHeight = particles->sourceRectHeight;
+		ParticleInstance* const __restrict dst = out;
+
+		// Streams are read linearly and interleaved into records. out[0] is the record for 'start'.
+		#pragma omp simd
+		for (int32_t i = start; i < end; i++) {
+			ParticleInstance& instance = dst[i - start];
+			instance.positionX = positionX[i];
+			instance.positionY = positionY[i];
+			instance.scaleX = scaleX[i];
+			instance.scaleY = scaleY[i];
+			instance.rotation = rotation[i];
+			instance.color = color[i];
+			instance.uvX = (float)rectX[i] * invWidth;
+			instance.uvY = (float)rectY[i] * invHeight;
+			instance.uvWidth = (float)rectWidth[i] * invWidth;
+			instance.uvHeight = (float)rectHeight[i] * invHeight;
+		}
+		convertColors(out, end - start, colorFormat);
+	}
+
+	void ParticleInstances::write(const Particle* const particles, const int32_t start, const int32_t end,
+		const float textureWidth, const float textureHeight, ParticleInstance* const out,
+		const InstanceColor::Format colorFormat)
+	{
+		const float invWidth = 1.0f / textureWidth;
+		const float invHeight = 1.0f / textureHeight;
+		for (int32_t i = start; i < end; i++) {
+			writeInstance(particles[i], invWidth, invHeight, out[i - start]);
+		}
+		convertColors(out, end - start, colorFormat);
+	}
+
+	const int32_t ParticleInstances::writeAll(ParticleBuffer* const particles, const int32_t length,
+		const float textureWidth, const float textureHeight, ParticleInstance* const out, const int32_t maxLength,
+		const InstanceColor::Format colorFormat)
+	{
+		checkTextureSize(textureWidth, textureHeight);
+		const int32_t count = length < maxLength ? length : maxLength;
+		if (count <= 0)
+			return 0;
+
+		ThreadPool::get().parallelFor(0, count, NativeModule::DEFAULT_CHUNK_SIZE, [&](const int32_t start, const int32_t end) {
+			write(particles, start, end, textureWidth, textureHeight, &out[start], colorFormat);
+		});
+		return count;
+	}
+
+	const int32_t ParticleInstances::writeAll(const Particle* const particles, const int32_t length,
+		const float textureWidth, const float textureHeight, ParticleInstance* const out, const int32_t maxLength,
+		const InstanceColor::Format colorFormat)
+	{
+		checkTextureSize(textureWidth, textureHeight);
+		const int32_t count = length < maxLength ? length : maxLength;
+		if (count <= 0)
+			return 0;
+
+		ThreadPool::get().parallelFor(0, count, NativeModule::DEFAULT_CHUNK_SIZE, [&](const int32_t start, const int32_t end) {
+			write(particles, start, end, textureWidth, textureHeight, &out[start], colorFormat);
+		});
+		return count;
+	}
+
+	const int32_t ParticleInstances::writeIndexed(ParticleBuffer* const particles, const int32_t* const indices, const int32_t length,
+		const float textureWidth, const float textureHeight, ParticleInstance* const out, const int32_t maxLength,
+		const InstanceColor::Format colorFormat)
+	{
+		checkTextureSize(textureWidth, textureHeight);
+		const int32_t count = length < maxLength ? length : maxLength;
+		if (count <= 0)
+			return 0;
+
+		const float invWidth = 1.0f / textureWidth;
+		const float invHeight = 1.0f / textureHeight;
+		ThreadPool::get().parallelFor(0, count, NativeModule::DEFAULT_CHUNK_SIZE, [&](const int32_t start, const int32_t end) {
+			for (int32_t i = start; i < end; i++) {
+				const int32_t index = indices[i];
+				ParticleInstance& instance = out[i];
+				instance.positionX = particles->positionX[index];
+				instance.positionY = particles->positionY[index];
+				instance.scaleX = particles->scaleX[index];
+				instance.scaleY = particles->scaleY[index];
+				instance.rotation = particles->spriteRotation[index];
+				instance.color = particles->color[index];
+				instance.uvX = (float)particles->sourceRectX[index] * invWidth;
+				instance.uvY = (float)particles->sourceRectY[index] * invHeight;
+				instance.uvWidth = (float)particles->sourceRectWidth[index] * invWidth;
+				instance.uvHeight = (float)particles->sourceRectHeight[index] * invHeight;
+			}
+			convertColors(&out[start], end - start, colorFormat);
+		});
+		return count;
+	}
+
+	const int32_t ParticleInstances::writeIndexed(const Particle* const particles, const int32_t* const indices, const int32_t length,
+		const float textureWidth, const float textureHeight, ParticleInstance* const out, const int32_t maxLength,
+		const InstanceColor::Format colorFormat)
+	{
+		checkTextureSize(textureWidth, textureHeight);
+		const int32_t count = length < maxLength ? length : maxLength;
+		if (count <= 0)
+			return 0;
+
+		const float invWidth = 1.0f / textureWidth;
+		const float invHeight = 1.0f / textureHeight;
+		ThreadPool::get().parallelFor(0, count, NativeModule::DEFAULT_CHUNK_SIZE, [&](const int32_t start, const int32_t end) {
+			for (int32_t i = start; i < end; i++) {
+				writeInstance(particles[indices[i]], invWidth, invHeight, out[i]);
+			}
+			convertColors(&out[start], end - start, colorFormat);
+		});
+		return count;
+	}
+
+	const int32_t ParticleInstances::writeCompact(ParticleBuffer* const particles, const int32_t* const indices, const int32_t length,
+		FrameTable& frames, CompactParticleInstance* const out, const int32_t maxLength,
+		const InstanceColor::Format colorFormat)
+	{
+		const int32_t count = length < maxLength ? length : maxLength;
+		frames.setMissCount(0);
+		if (count <= 0)
+			return 0;
+
+		const KernelTable& kernels = SimdKernels::get();
+		std::atomic<int32_t> misses(0);
+		ThreadPool::get().parallelFor(0, count, NativeModule::DEFAULT_CHUNK_SIZE, [&](const int32_t start, const int32_t end) {
+			// Gather a block of floats, convert them in one kernel call, then interleave into records.
+			const int32_t blockSize = 256;
+			float floats[3][blockSize];
+			uint16_t halves[3][blockSize];
+			int32_t frameHint = 0;
+			int32_t rangeMisses = 0;
+			for (int32_t blockStart = start; blockStart < end; blockStart += blockSize) {
+				const int32_t blockCount = (end - blockStart) < blockSize ? (end - blockStart) : blockSize;
+				for (int32_t j = 0; j < blockCount; j++) {
+					const int32_t index = indices != nullptr ? indices[blockStart + j] : blockStart + j;
+					floats[0][j] = particles->scaleX[index];
+					floats[1][j] = particles->scaleY[index];
+					floats[2][j] = wrapAngle(particles->spriteRotation[index]);
+				}
+				for (int32_t k = 0; k < 3; k++) {
+					kernels.toHalves(floats[k], halves[k], blockCount);
+				}
+				for (int32_t j = 0; j < blockCount; j++) {
+					const int32_t index = indices != nullptr ? indices[blockStart + j] : blockStart + j;
+					CompactParticleInstance& instance = out[blockStart + j];
+					instance.positionX = particles->positionX[index];
+					instance.positionY = particles->positionY[index];
+					instance.scaleX = halves[0][j];
+					instance.scaleY = halves[1][j];
+					instance.rotation = halves[2][j];
+					const int32_t frame = frames.findFrame(particles->sourceRectX[index], particles->sourceRectY[index],
+						particles->sourceRectWidth[index], particles->sourceRectHeight[index], frameHint);
+					rangeMisses += frame == FrameTable::NO_FRAME ? 1 : 0;
+					instance.frame = (uint16_t)(frame == FrameTable::NO_FRAME ? 0 : frame);
+					instance.color = particles->color[index];
+				}
+				convertColors(&out[blockStart], blockCount, colorFormat);
+			}
+			if (rangeMisses != 0)
+				misses += rangeMisses;
+		});
+		frames.setMissCount(misses);
+		return count;
+	}
+
+	const int32_t ParticleInstances::cull(ParticleBuffer* const particles, const int32_t length, const ViewBounds& view,
+		uint8_t* const visibleMask, int32_t* const indices)
+	{
+		if (length <= 0)
+			return 0;
+
+		// Work is split on whole chunks, so threads never share a mask byte.
+		const KernelTable& kernels = SimdKernels::get();
+		const int32_t chunkSize = NativeModule::DEFAULT_CHUNK_SIZE;
+		const int32_t chunkCount = (length + chunkSize - 1) / chunkSize;
+		const int32_t grain = (ThreadPool::get().getMinGrainSize() + chunkSize - 1) / chunkSize;
+		ThreadPool::get().parallelForEach(0, chunkCount, grain, [&](const int32_t chunkBegin, const int32_t chunkEnd) {
+			const int32_t start = chunkBegin * chunkSize;
+			const int32_t end = chunkEnd * chunkSize < length ? chunkEnd * chunkSize : length;
+			ParticleBounds bounds;
+			bounds.positionX = particles->positionX + start;
+			bounds.positionY = particles->positionY + start;
+			bounds.scaleX = particles->scaleX + start;
+			bounds.scaleY = particles->scaleY + start;
+			bounds.rectWidth = particles->sourceRectWidth + start;
+			bounds.rectHeight = particles->sourceRectHeight + start;
+			kernels.buildVisibleMask(bounds, view, visibleMask + (start >> 3), end - start);
+		});
+
+		// Mask to indices. Empty bytes are skipped, so mostly off-screen emitters cost little here.
+		int32_t count = 0;
+		for (int32_t byte = 0; byte < (length + 7) >> 3; byte++) {
+			uint32_t bits = visibleMask[byte];
+			const int32_t base = byte << 3;
+			while (bits != 0) {
+				int32_t bit = 0;
+				while ((bits & (1u << bit)) == 0) {
+					bit++;
+				}
+				indices[count++] = base + bit;
+				bits &= bits - 1;
+			}
+		}
+		return count;
+	}
+
+	const int32_t ParticleInstances::cull(const Particle* const particles, const int32_t length, const ViewBounds& view,
+		int32_t* const indices)
+	{
+		int32_t count = 0;
+		for (int32_t i = 0; i < length; i++) {
+			indices[count] = i;
+			count += isVisible(particles[i], view) ? 1 : 0;
+		}
+		return count;
+	}
+
+	#pragma region INTEROP METHODS.
+
+	// For particles owned by managed code. Natively owned particles use nativeEmitter_WriteInstances.
+	LIB_API(int32_t) nativeParticles_WriteInstances(const Particle* const particleArrPtr, const int32_t length,
+		const float textureWidth, const float textureHeight, ParticleInstance* const instanceArrPtr, const int32_t maxLength)
+	{
+		return ParticleInstances::writeAll(particleArrPtr, length, textureWidth, textureHeight, instanceArrPtr, maxLength);
+	}
+
+	LIB_API(int32_t) nativeParticles_Cull(const Particle* const particleArrPtr, const int32_t length, const ViewBounds view,
+		int32_t* const indexArrPtr)
+	{
+		return ParticleInstances::cull(particleArrPtr, length, view, indexArrPtr);
+	}
+
+	LIB_API(int32_t) nativeParticles_WriteInstancesIndexed(const Particle* const particleArrPtr, const int32_t* const indexArrPtr, const int32_t length,
+		const float textureWidth, const float textureHeight, ParticleInstance* const instanceArrPtr, const int32_t maxLength)
+	{
+		return ParticleInstances::writeIndexed(particleArrPtr, indexArrPtr, length, textureWidth, textureHeight, instanceArrPtr, maxLength);
+	}
+
+	#pragma endregion
+
+}
\ No newline at end of file
@@ -0,0 +1,85 @@
+#pragma once
+
+#ifndef PARTICLEINSTANCES_H
+#define PARTICLEINSTANCES_H
+
+#include "src/SE.Native.h"
+#include "Particle.h"
+#include "ParticleBuffer.h"
+#include "FrameTable.h"
+#include "src/Utility/SimdKernels.h"
+
+namespace Particles {
+
+	namespace InstanceColor {
+		// Hsla keeps ParticleColor as is, for shaders that convert per pixel. Rgba converts to RGBA8
+		// on the CPU in SIMD batches, so the shader can use the color directly.
+		enum Format : int32_t { Hsla, Rgba };
+	}
+
+	// Per-instance vertex data for the instanced particle renderer, 40 bytes. The managed vertex
+	// declaration must match this layout.
+	struct ParticleInstance {
+	public:
+		float positionX, positionY;
+		float scaleX, scaleY;
+		float rotation;
+		ParticleColor color;					// Packed HSLA bytes, or RGBA8 (see InstanceColor).
+		float uvX, uvY, uvWidth, uvHeight;		// Source rectangle divided by the texture size.
+	};
+
+	// Quantized instance record, 20 bytes. Scale and rotation are IEEE half floats, and the source
+	// rectangle is replaced by an index into the emitter's FrameTable.
+	struct CompactParticleInstance {
+	public:
+		float positionX, positionY;				// Kept full precision, world coordinates outgrow half floats.
+		uint16_t scaleX, scaleY;
+		uint16_t rotation;						// Wrapped to [-pi, pi) before conversion.
+		uint16_t frame;
+		ParticleColor color;
+	};
+
+	// Builds instance records straight into a caller-owned (pinned or mapped) buffer, so the
+	// renderer can upload particles without a managed per-particle loop.
+	class ParticleInstances {
+	public:
+		static void write(ParticleBuffer* const particles, const int32_t start, const int32_t end,
+			const float textureWidth, const float textureHeight, ParticleInstance* const out,
+			const InstanceColor::Format colorFormat = InstanceColor::Hsla);
+		static void write(const Particle* const particles, const int32_t start, const int32_t end,
+			const float textureWidth, const float textureHeight, ParticleInstance* const out,
+			const InstanceColor::Format colorFormat = InstanceColor::Hsla);
+
+		// Writes min(length, maxLength) records, split over the thread pool. Returns the count written.
+		static const int32_t writeAll(ParticleBuffer* const particles, const int32_t length,
+			const float textureWidth, const float textureHeight, ParticleInstance* const out, const int32_t maxLength,
+			const InstanceColor::Format colorFormat = InstanceColor::Hsla);
+		static const int32_t writeAll(const Particle* const particles, const int32_t length,
+			const float textureWidth, const float textureHeight, ParticleInstance* const out, const int32_t maxLength,
+			const InstanceColor::Format colorFormat = InstanceColor::Hsla);
+
+		// Gathered variants: out[i] is the record for particle indices[i].
+		static const int32_t writeIndexed(ParticleBuffer* const particles, const int32_t* const indices, const int32_t length,
+			const float textureWidth, const float textureHeight, ParticleInstance* const out, const int32_t maxLength,
+			const InstanceColor::Format colorFormat = InstanceColor::Hsla);
+		static const int32_t writeIndexed(const Particle* const particles, const int32_t* const indices, const int32_t length,
+			const float textureWidth, const float textureHeight, ParticleInstance* const out, const int32_t maxLength,
+			const InstanceColor::Format colorFormat = InstanceColor::Hsla);
+
+		// Compact records. With indices, out[i] is the record for particle indices[i], otherwise for particle i.
+		static const int32_t writeCompact(ParticleBuffer* const particles, const int32_t* const indices, const int32_t length,
+			FrameTable& frames, CompactParticleInstance* const out, const int32_t maxLength,
+			const InstanceColor::Format colorFormat = InstanceColor::Hsla);
+
+		// Indices (ascending) of the particles whose bounding circle overlaps the view. The radius is half
+		// the diagonal of sourceRectangle * scale, so any rotation is covered. visibleMask needs
+		// (length + 7) / 8 bytes of scratch and indices room for length entries. Returns the visible count.
+		static const int32_t cull(ParticleBuffer* const particles, const int32_t length, const ViewBounds& view,
+			uint8_t* const visibleMask, int32_t* const indices);
+		static const int32_t cull(const Particle* const particles, const int32_t length, const ViewBounds& view,
+			int32_t* const indices);
+	};
+
+}
+
+#endif
\ No newline at end of file
@@ -4,6 +4,7 @@
 #define PARTICLEMATH_H
 
 #include <stdint.h>
+#include <math.h>
 
 namespace Particles {
 	class ParticleMath {
@@ -56,6 +57,29 @@ namespace Particles {
 
 			return val;
 		}
+
+		// Splits a velocity back into direction and speed. A stopped particle keeps its old direction; its
+		// velocity is 0 then, so that's added instead of selected, which keeps callers' loops vectorized.
+		#pragma omp declare simd
+		static inline void setVelocity(const float velocityX, const float velocityY, float* const directionX, float* const directionY, float* const speed)
+		{
+			const float length = sqrtf((velocityX * velocityX) + (velocityY * velocityY));
+			const float inverseLength = 1.0f / (length > 0.0f ? length : 1.0f);
+			const float keep = length > 0.0f ? 0.0f : 1.0f;
+			*directionX = (velocityX * inverseLength) + (*directionX * keep);
+			*directionY = (velocityY * inverseLength) + (*directionY * keep);
+			*speed = length;
+		}
+
+		// Ends a particle's life on this update if 'dies' is set, by running its time alive out.
+		#pragma omp declare simd
+		static inline void kill(const bool dies, const float initialLife, float* const timeAlive, float* const life)
+		{
+			const float alive = *timeAlive;
+			const float age = *life;
+			*timeAlive = (dies && alive < initialLife) ? initialLife : alive;
+			*life = (dies && age < 1.0f) ? 1.0f : age;
+		}
 	};
 }
 
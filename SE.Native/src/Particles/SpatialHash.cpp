@@ -0,0 +1,160 @@
+#include "SpatialHash.h"
+#include "src/Utility/ThreadPool.h"
+#include <stdexcept>
+#include <string.h>
+
+namespace Particles {
+
+	using namespace Utility;
+
+	SpatialHash::SpatialHash() { }
+
+	void SpatialHash::build(const float* const positionX, const float* const positionY, const int32_t length, const float cellSize)
+	{
+		if (!(cellSize > 0.0f))
+			throw std::invalid_argument("Cell size must be positive!");
+
+		this->cellSize = cellSize;
+		this->length = length < 0 ? 0 : length;
+		inverseCellSize = 1.0f / cellSize;
+
+		// About two buckets per particle keeps collisions between cells rare.
+		bucketCount = MIN_BUCKETS;
+		while (bucketCount < this->length * 2) {
+			bucketCount <<= 1;
+		}
+		bucketMask = (uint32_t)bucketCount - 1;
+
+		// One row per grid row of the particles' extent, plus a cell either side. Rows stay at most a
+		// quarter of the table, so the three rows of a 3x3 neighborhood never share buckets.
+		float minX = 0.0f, maxX = 0.0f;
+		if (this->length > 0) {
+			minX = positionX[0];
+			maxX = positionX[0];
+			#pragma omp simd reduction(min:minX) reduction(max:maxX)
+			for (int32_t i = 0; i < this->length; i++) {
+				minX = positionX[i] < minX ? positionX[i] : minX;
+				maxX = positionX[i] > maxX ? positionX[i] : maxX;
+			}
+		}
+		const float width = ((maxX - minX) * inverseCellSize) + 3.0f;
+		const float maxStride = (float)(bucketCount / 4);
+		rowStride = (uint32_t)(width < maxStride ? width : maxStride);
+
+		const int32_t rangeCount = buildRanges();
+		if ((int32_t)particleBuckets.size() < this->length) {
+			particleBuckets.resize(this->length);
+			indices.resize(this->length);
+			sortedX.resize(this->length);
+			sortedY.resize(this->length);
+		}
+		if ((int32_t)rangeCounts.size() < rangeCount * bucketCount)
+			rangeCounts.resize(rangeCount * bucketCount);
+		if ((int32_t)bucketStart.size() < bucketCount + 1)
+			bucketStart.resize(bucketCount + 1);
+
+		const int32_t total = this->length;
+		const int32_t rangeSize = (total + rangeCount - 1) / rangeCount;
+		int32_t* const buckets = particleBuckets.data();
+		int32_t* const counts = rangeCounts.data();
+		int32_t* const starts = bucketStart.data();
+		ThreadPool& pool = ThreadPool::get();
+
+		// 1. Bucket of every particle, counted per range.
+		pool.parallelForEach(0, rangeCount, 1, [&](const int32_t rangeBegin, const int32_t rangeEnd) {
+			for (int32_t range = rangeBegin; range < rangeEnd; range++) {
+				int32_t* const rangeCount = counts + ((size_t)range * bucketCount);
+				memset(rangeCount, 0, (size_t)bucketCount * sizeof(int32_t));
+				const int32_t end = (range + 1) * rangeSize < total ? (range + 1) * rangeSize : total;
+				for (int32_t i = range * rangeSize; i < end; i++) {
+					const int32_t bucket = getBucket(cellCoordinate(positionX[i]), cellCoordinate(positionY[i]));
+					buckets[i] = bucket;
+					rangeCount[bucket]++;
+				}
+			}
+		});
+
+		// 2. Per bucket, turn the range counts into offsets within the bucket, then prefix sum the bucket sizes.
+		pool.parallelFor(0, bucketCount, 4096, [&](const int32_t begin, const int32_t end) {
+			for (int32_t bucket = begin; bucket < end; bucket++) {
+				int32_t running = 0;
+				for (int32_t range = 0; range < rangeCount; range++) {
+					int32_t& count = counts[((size_t)range * bucketCount) + bucket];
+					const int32_t size = count;
+					count = running;
+					running += size;
+				}
+				starts[bucket + 1] = running;
+			}
+		});
+		starts[0] = 0;
+		for (int32_t bucket = 0; bucket < bucketCount; bucket++) {
+			starts[bucket + 1] += starts[bucket];
+		}
+
+		// 3. Scatter. Each range writes its own slots, in index order.
+		int32_t* const sortedIndices = indices.data();
+		float* const x = sortedX.data();
+		float* const y = sortedY.data();
+		pool.parallelForEach(0, rangeCount, 1, [&](const int32_t rangeBegin, const int32_t rangeEnd) {
+			for (int32_t range = rangeBegin; range < rangeEnd; range++) {
+				int32_t* const cursor = counts + ((size_t)range * bucketCount);
+				const int32_t end = (range + 1) * rangeSize < total ? (range + 1) * rangeSize : total;
+				for (int32_t i = range * rangeSize; i < end; i++) {
+					const int32_t bucket = buckets[i];
+					const int32_t slot = starts[bucket] + cursor[bucket]++;
+					sortedIndices[slot] = i;
+					x[slot] = positionX[i];
+					y[slot] = positionY[i];
+				}
+			}
+		});
+	}
+
+	int32_t SpatialHash::buildRanges()
+	{
+		// One range per thread, but not so many that clearing their counters outweighs the counting.
+		// The sort is stable, so the result is the same for any range count.
+		int32_t ranges = ThreadPool::get().getThreadCount();
+		const int32_t byLength = (length / (bucketCount / 4)) + 1;
+		ranges = ranges < byLength ? ranges : byLength;
+		ranges = ranges < MAX_BUILD_RANGES ? ranges : MAX_BUILD_RANGES;
+		return ranges > 1 ? ranges : 1;
+	}
+
+	const float SpatialHash::getCellSize()
+	{
+		return cellSize;
+	}
+
+	const int32_t SpatialHash::getLength()
+	{
+		return length;
+	}
+
+	const int32_t SpatialHash::getBucketCount()
+	{
+		return bucketCount;
+	}
+
+	const int32_t* SpatialHash::getBucketStart()
+	{
+		return bucketStart.data();
+	}
+
+	const int32_t* SpatialHash::getIndices()
+	{
+		return indices.data();
+	}
+
+	const float* SpatialHash::getPositionX()
+	{
+		return sortedX.data();
+	}
+
+	const float* SpatialHash::getPositionY()
+	{
+		return sortedY.data();
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,70 @@
+#pragma once
+
+#ifndef SPATIALHASH_H
+#define SPATIALHASH_H
+
+#include "src/SE.Native.h"
+#include <stdint.h>
+#include <vector>
+
+namespace Particles {
+
+	// Uniform grid over particle positions for neighbor queries, rebuilt every frame with a parallel
+	// counting sort. Cells map row-major into a power-of-two bucket table with a row stride fitted to
+	// the particles' extent, so neighboring cells are neighboring buckets, and a grid wider or taller
+	// than the table wraps around instead of growing it. Within a bucket particles keep index order,
+	// whatever the thread count. Buffers only grow, so steady-state frames don't allocate.
+	class SpatialHash {
+	public:
+		static const int32_t MAX_BUILD_RANGES = 16;
+		static const int32_t MIN_BUCKETS = 64;
+
+		SpatialHash();
+
+		void build(const float* const positionX, const float* const positionY, const int32_t length, const float cellSize);
+
+		const float getCellSize();
+		const int32_t getLength();
+		const int32_t getBucketCount();
+
+		inline int32_t cellCoordinate(const float value) const
+		{
+			const float scaled = value * inverseCellSize;
+			const int32_t truncated = (int32_t)scaled;
+			return truncated - ((float)truncated > scaled ? 1 : 0);
+		}
+
+		inline int32_t getBucket(const int32_t cellX, const int32_t cellY) const
+		{
+			return (int32_t)((((uint32_t)cellY * rowStride) + (uint32_t)cellX) & bucketMask);
+		}
+
+		// Bucket b holds entries [getBucketStart()[b], getBucketStart()[b + 1]), so consecutive buckets
+		// are one contiguous run. Entries are particle indices with a copy of their position taken at
+		// build time. Cells beyond the table's extent wrap around and share buckets.
+		const int32_t* getBucketStart();
+		const int32_t* getIndices();
+		const float* getPositionX();
+		const float* getPositionY();
+
+	private:
+		float cellSize = 1.0f;
+		float inverseCellSize = 1.0f;
+		int32_t length = 0;
+		int32_t bucketCount = 0;
+		uint32_t bucketMask = 0;
+		uint32_t rowStride = 0;
+
+		std::vector<int32_t> particleBuckets;
+		std::vector<int32_t> rangeCounts;		// A row of bucketCount counters per build range.
+		std::vector<int32_t> bucketStart;
+		std::vector<int32_t> indices;
+		std::vector<float> sortedX;
+		std::vector<float> sortedY;
+
+		int32_t buildRanges();
+	};
+
+}
+
+#endif
\ No newline at end of file
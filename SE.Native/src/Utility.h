@@ -9,5 +9,6 @@ namespace Utility { }
 #include "Utility/Curve.h"
 #include "Utility/Int4.h"
 #include "Utility/Random.h"
+#include "Utility/AlignedMemory.h"
 
 #endif
\ No newline at end of file
@@ -0,0 +1,52 @@
+#pragma once
+
+#ifndef UTILITY_ALIGNEDMEMORY_H
+#define UTILITY_ALIGNEDMEMORY_H
+
+#include <stddef.h>
+#include <stdlib.h>
+#if defined(_WIN32)
+	#include <malloc.h>
+#endif
+
+namespace Utility { namespace AlignedMemory {
+
+	// Cache line size. Streams handed to SIMD loops are aligned (and padded) to this.
+	const size_t CACHE_LINE = 64;
+
+	static inline const size_t alignSize(const size_t size, const size_t alignment = CACHE_LINE)
+	{
+		return (size + alignment - 1) & ~(alignment - 1);
+	}
+
+	static inline void* allocate(const size_t size, const size_t alignment = CACHE_LINE)
+	{
+		if (size == 0)
+			return nullptr;
+
+#if defined(_WIN32)
+		return _aligned_malloc(size, alignment);
+#else
+		void* ptr = nullptr;
+		if (posix_memalign(&ptr, alignment, size) != 0)
+			return nullptr;
+
+		return ptr;
+#endif
+	}
+
+	static inline void free(void* const ptr)
+	{
+		if (ptr == nullptr)
+			return;
+
+#if defined(_WIN32)
+		_aligned_free(ptr);
+#else
+		::free(ptr);
+#endif
+	}
+
+}}
+
+#endif
\ No newline at end of file
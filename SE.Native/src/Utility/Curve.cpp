@@ -1,5 +1,6 @@
 #include "Curve.h"
 #include "MathUtil.h"
+#include "SimdKernels.h"
 #include <cmath>
 #include "src/SE.Native.h"
 using namespace Utility;
@@ -156,15 +157,15 @@ namespace Utility {
 	const float Curve::GetCurvePosition(const float position)
 	{
 		const size_t keysCount = keys.count;
-		CurveKey& prev = keys[0];
+		const CurveKey* prev = &keys[0];
 		for (size_t i = 1; i < keysCount; ++i) {
 			CurveKey& next = keys[i];
 			if (next.position >= position) {
-				if (prev.continuity == CurveContinuity::Step) {
-					return position >= 1.0f ? next.value : prev.value;
+				if (prev->continuity == CurveContinuity::Step) {
+					return position >= 1.0f ? next.value : prev->value;
 				}
 
-				float t = (position - prev.position) / (next.position - prev.position);//to have t in [0,1]
+				float t = (position - prev->position) / (next.position - prev->position);//to have t in [0,1]
 				float ts = t * t;
 				float tss = ts * t;
 
@@ -173,13 +174,157 @@ namespace Utility {
 				//http://en.wikipedia.org/wiki/Cubic_Hermite_spline
 				//P(t) = (2*t^3 - 3t^2 + 1)*P0 + (t^3 - 2t^2 + t)m0 + (-2t^3 + 3t^2)P1 + (t^3-t^2)m1
 				//with P0.value = prev.value , m0 = prev.tangentOut, P1= next.value, m1 = next.TangentIn
-				return (2 * tss - 3 * ts + 1.0f) * prev.value + (tss - 2 * ts + t) * prev.tangentOut + (3 * ts - 2 * tss) * next.value + (tss - ts) * next.tangentIn;
+				return (2 * tss - 3 * ts + 1.0f) * prev->value + (tss - 2 * ts + t) * prev->tangentOut + (3 * ts - 2 * tss) * next.value + (tss - ts) * next.tangentIn;
 			}
-			prev = next;
+			prev = &next;
 		}
 		return 0.0f;
 	}
 
+	namespace {
+		// Key arrays of curves up to this size are laid out on the stack, so unbaked evaluation
+		// doesn't allocate.
+		const size_t STACK_KEYS = 16;
+
+		CurveWrap makeWrap(const CurveKey& first, const CurveKey& last, const CurveLoopType::CurveLoopType preLoop, const CurveLoopType::CurveLoopType postLoop)
+		{
+			CurveWrap wrap;
+			wrap.start = first.position;
+			wrap.end = last.position;
+			wrap.range = last.position - first.position;
+			wrap.invRange = wrap.range > MathUtil::EPSILON ? 1.0f / wrap.range : 0.0f;
+			wrap.delta = last.value - first.value;
+
+			// Same tangents Evaluate() extrapolates with.
+			wrap.pre = CurveBakedLoop(preLoop, first.tangentIn);
+			wrap.post = CurveBakedLoop(postLoop, first.tangentOut);
+			return wrap;
+		}
+	}
+
+	void Curve::EvaluateBatch(const float* const positions, float* const out, const size_t n)
+	{
+		const KernelTable& kernels = SimdKernels::get();
+		const size_t keysCount = keys.count;
+		if (keysCount < 2) {
+			const float value = keysCount == 0 ? 0.0f : keys[0].value;
+			for (size_t i = 0; i < n; i++) {
+				out[i] = value;
+			}
+			return;
+		}
+
+		float stackData[STACK_KEYS * 5];
+		std::vector<float> heapData;
+		float* keyData = stackData;
+		if (keysCount > STACK_KEYS) {
+			heapData.resize(keysCount * 5);
+			keyData = heapData.data();
+		}
+
+		CurveKeyArrays arrays;
+		arrays.position = keyData;
+		arrays.value = arrays.position + keysCount;
+		arrays.tangentIn = arrays.value + keysCount;
+		arrays.tangentOut = arrays.tangentIn + keysCount;
+		arrays.step = arrays.tangentOut + keysCount;
+		arrays.count = (int32_t)keysCount;
+		for (size_t k = 0; k < keysCount; k++) {
+			CurveKey& key = keys[k];
+			keyData[k] = key.position;
+			keyData[keysCount + k] = key.value;
+			keyData[(keysCount * 2) + k] = key.tangentIn;
+			keyData[(keysCount * 3) + k] = key.tangentOut;
+			keyData[(keysCount * 4) + k] = key.continuity == CurveContinuity::Step ? 1.0f : 0.0f;
+		}
+
+		kernels.evaluateCurve(makeWrap(keys[0], keys[keysCount - 1], preLoop, postLoop), arrays, positions, out, n);
+	}
+
+	CurveBakedLoop::CurveBakedLoop(const CurveLoopType::CurveLoopType loopType, const float tangent)
+	{
+		switch (loopType) {
+			case CurveLoopType::Constant:
+				break;
+			case CurveLoopType::Linear: {
+				slope = tangent;
+			} break;
+			case CurveLoopType::Cycle: {
+				repeat = 1.0f;
+			} break;
+			case CurveLoopType::CycleOffset: {
+				repeat = 1.0f;
+				offset = 1.0f;
+			} break;
+			case CurveLoopType::Oscillate: {
+				repeat = 1.0f;
+				mirror = 1.0f;
+			} break;
+		}
+	}
+
+	void Curve::EvaluateBakedBatch(const float* const positions, float* const out, const size_t n)
+	{
+		if (!IsBaked()) {
+			EvaluateBatch(positions, out, n);
+			return;
+		}
+
+		SimdKernels::get().evaluateBakedCurve(bakedWrap, baked.data(), (int32_t)baked.size() - 1, positions, out, n);
+	}
+
+	void Curve::Bake(const int32_t resolution)
+	{
+		const int32_t samples = resolution < 2 ? 2 : resolution;
+		bakeStale = false;
+		if (keys.count == 0) {
+			bakedWrap = CurveWrap();
+			baked.assign((size_t)samples, 0.0f);
+			return;
+		}
+
+		CurveKey& first = keys[0];
+		CurveKey& last = keys[keys.count - 1];
+
+		bakedWrap = makeWrap(first, last, preLoop, postLoop);
+
+		std::vector<float> values((size_t)samples);
+		for (int32_t i = 0; i < samples; i++) {
+			values[i] = Evaluate(bakedWrap.start + (bakedWrap.range * ((float)i / (float)(samples - 1))));
+		}
+		baked.swap(values);
+	}
+
+	void Curve::EnsureBaked()
+	{
+		if (!IsBaked()) {
+			Bake();
+		} else if (bakeStale) {
+			Bake(GetBakedResolution());
+		}
+	}
+
+	void Curve::Invalidate()
+	{
+		bakeStale = true;
+	}
+
+	void Curve::ClearBake()
+	{
+		baked.clear();
+		bakeStale = false;
+	}
+
+	const bool Curve::IsBaked()
+	{
+		return !baked.empty();
+	}
+
+	const int32_t Curve::GetBakedResolution()
+	{
+		return (int32_t)baked.size();
+	}
+
 	void Curve::ComputeTangents(const CurveTangent::CurveTangent tangentType)
 	{
 		ComputeTangents(tangentType, tangentType);
@@ -191,6 +336,7 @@ namespace Utility {
 		for (size_t i = 0; i < keysCount; ++i) {
 			ComputeTangent(i, tangentInType, tangentOutType);
 		}
+		bakeStale = true;
 	}
 
 	void Curve::ComputeTangent(const size_t keyIndex, const CurveTangent::CurveTangent tangentType)
@@ -202,6 +348,7 @@ namespace Utility {
 	{
 		const size_t keysCount = keys.count;
 
+		bakeStale = true;
 		CurveKey& key = keys[keyIndex];
 		float p0, p, p1;
 		p0 = p = p1 = key.position;
@@ -260,6 +407,38 @@ namespace Utility {
 	{
 		return Vector4(x.Evaluate(position), y.Evaluate(position), z.Evaluate(position), w.Evaluate(position));
 	}
+	void Curve4::Bake(const int32_t resolution)
+	{
+		x.Bake(resolution);
+		y.Bake(resolution);
+		z.Bake(resolution);
+		w.Bake(resolution);
+	}
+
+	void Curve4::EnsureBaked()
+	{
+		x.EnsureBaked();
+		y.EnsureBaked();
+		z.EnsureBaked();
+		w.EnsureBaked();
+	}
+
+	void Curve4::EvaluateBatch(const float* const positions, float* const outX, float* const outY, float* const outZ, float* const outW, const size_t n)
+	{
+		x.EvaluateBatch(positions, outX, n);
+		y.EvaluateBatch(positions, outY, n);
+		z.EvaluateBatch(positions, outZ, n);
+		w.EvaluateBatch(positions, outW, n);
+	}
+
+	void Curve4::EvaluateBakedBatch(const float* const positions, float* const outX, float* const outY, float* const outZ, float* const outW, const size_t n)
+	{
+		x.EvaluateBakedBatch(positions, outX, n);
+		y.EvaluateBakedBatch(positions, outY, n);
+		z.EvaluateBakedBatch(positions, outZ, n);
+		w.EvaluateBakedBatch(positions, outW, n);
+	}
+
 	const Vector2 Curve2::Evaluate(const float position)
 	{
 		return Vector2(x.Evaluate(position), y.Evaluate(position));
@@ -273,6 +452,32 @@ namespace Utility {
 	LIB_API(void) util_Curve_Add(Curve* curvePtr, float position, float value)
 	{
 		curvePtr->keys.add(position, value);
+		curvePtr->Invalidate();
+	}
+
+	LIB_API(void) util_Curve_Bake(Curve* curvePtr, int32_t resolution)
+	{
+		curvePtr->Bake(resolution);
+	}
+
+	LIB_API(void) util_Curve_EvaluateBatch(Curve* curvePtr, const float* positions, float* out, int32_t length)
+	{
+		curvePtr->EvaluateBatch(positions, out, (size_t)length);
+	}
+
+	LIB_API(void) util_Curve_EvaluateBakedBatch(Curve* curvePtr, const float* positions, float* out, int32_t length)
+	{
+		curvePtr->EvaluateBakedBatch(positions, out, (size_t)length);
+	}
+
+	LIB_API(void) util_Curve4_EvaluateBatch(Curve4* curvePtr, const float* positions, float* outX, float* outY, float* outZ, float* outW, int32_t length)
+	{
+		curvePtr->EvaluateBatch(positions, outX, outY, outZ, outW, (size_t)length);
+	}
+
+	LIB_API(void) util_Curve4_EvaluateBakedBatch(Curve4* curvePtr, const float* positions, float* outX, float* outY, float* outZ, float* outW, int32_t length)
+	{
+		curvePtr->EvaluateBakedBatch(positions, outX, outY, outZ, outW, (size_t)length);
 	}
 
 	LIB_API(Curve2*) util_Curve2_Ctor(Curve x, Curve y)
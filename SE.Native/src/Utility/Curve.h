@@ -3,6 +3,9 @@
 #ifndef CURVE_H
 #define CURVE_H
 
+#include <stddef.h>
+#include <stdint.h>
+#include <math.h>
 #include <vector>
 #include <src/Utility.h>
 
@@ -55,15 +58,126 @@ namespace Utility {
 	};
 
 
+	// Loop behaviour on one side of a baked curve's key range. Precomputed from a CurveLoopType so
+	// baked lookups blend between the loop formulas instead of switching on the loop type.
+	struct CurveBakedLoop {
+	public:
+		float repeat = 0.0f;	// Cycle, CycleOffset, Oscillate: wrap back into the key range.
+		float mirror = 0.0f;	// Oscillate: odd cycles run backwards.
+		float offset = 0.0f;	// CycleOffset: every cycle adds (last.value - first.value).
+		float slope = 0.0f;		// Linear: extrapolate along a key tangent.
+
+		CurveBakedLoop() { }
+		CurveBakedLoop(const CurveLoopType::CurveLoopType loopType, const float tangent);
+	};
+
+	// A curve's key range and loop behaviour as plain data, shared by baked lookups and the
+	// batch kernels in SimdKernels.
+	struct CurveWrap {
+	public:
+		float start = 0.0f;
+		float end = 0.0f;
+		float range = 0.0f;
+		float invRange = 0.0f;
+		float delta = 0.0f;		// last.value - first.value
+		CurveBakedLoop pre, post;
+	};
+
+	// Key data as SoA, so segment search and Hermite terms can be gathered per lane.
+	struct CurveKeyArrays {
+	public:
+		const float* position;
+		const float* value;
+		const float* tangentIn;
+		const float* tangentOut;
+		const float* step;		// 1 for Step continuity, else 0.
+		int32_t count;
+	};
+
+	// These are static (internal linkage) rather than members: SimdKernels compiles them once per
+	// instruction set, and a shared inline copy could be resolved to the wrong one by the linker.
+
+	// Branch-free wrap of a position into the key range. 'wrapped' is the wrapped position and 't'
+	// the same in key range units (0 at the first key, 1 at the last). 'extra' is the value offset
+	// the loop type adds on top of the curve value at 'wrapped' (CycleOffset, Linear).
+	static inline void wrapCurvePosition(const CurveWrap& wrap, const float position, float& wrapped, float& t, float& extra)
+	{
+		const float u = (position - wrap.start) * wrap.invRange;
+		const bool before = position < wrap.start;
+		const bool outside = before || position > wrap.end;
+		const float repeat = before ? wrap.pre.repeat : wrap.post.repeat;
+		const float mirror = before ? wrap.pre.mirror : wrap.post.mirror;
+		const float offset = before ? wrap.pre.offset : wrap.post.offset;
+		const float slope = before ? wrap.pre.slope : wrap.post.slope;
+
+		const float cycle = floorf(u);
+		const float local = u - cycle;
+		const float odd = cycle - (2.0f * floorf(cycle * 0.5f));
+		const float cycled = local + (mirror * odd * (1.0f - (2.0f * local)));
+		// Written so NaN (life of a particle with no lifetime) clamps to 0 rather than passing through.
+		const float clamped = u > 0.0f ? (u < 1.0f ? u : 1.0f) : 0.0f;
+		const float repeated = clamped + (repeat * (cycled - clamped));
+
+		t = outside ? repeated : clamped;
+		wrapped = outside ? (wrap.start + (repeated * wrap.range)) : position;
+		extra = outside ? ((offset * cycle * wrap.delta) + (slope * (u - clamped) * wrap.range)) : 0.0f;
+	}
+
+	// Lookup into a table resampled uniformly over the key range. lastIndex must be at least 1.
+	static inline const float evaluateBakedCurve(const CurveWrap& wrap, const float* const values, const int32_t lastIndex, const float position)
+	{
+		float wrapped, t, extra;
+		wrapCurvePosition(wrap, position, wrapped, t, extra);
+
+		// 't' can still be NaN or infinite for infinite positions, so the index is clamped before it's
+		// converted; casting either to an integer is undefined.
+		const float scaled = t * lastIndex;
+		const float index = scaled > 0.0f ? (scaled < (float)lastIndex ? scaled : (float)lastIndex) : 0.0f;
+		int32_t i = (int32_t)index;
+		i = i < lastIndex - 1 ? i : lastIndex - 1;
+		return values[i] + ((values[i + 1] - values[i]) * (index - i)) + extra;
+	}
+
 	struct Curve {
 	private:
 		CurveLoopType::CurveLoopType postLoop = CurveLoopType::Constant;
 		CurveLoopType::CurveLoopType preLoop = CurveLoopType::Constant;
 		const size_t GetNumberOfCycle(const float position);
 		const float GetCurvePosition(const float position);
+
+		// Baked lookup table, resampled uniformly over [first key, last key].
+		std::vector<float> baked;
+		CurveWrap bakedWrap;
+		bool bakeStale = false;
+
 	public:
+		static const int32_t DEFAULT_BAKE_RESOLUTION = 256;
+
 		CurveKeyCollection keys;
 		float Evaluate(const float position);
+
+		// Exact Hermite evaluation of every position.
+		void EvaluateBatch(const float* const positions, float* const out, const size_t n);
+		// Table lookups, as EvaluateBaked. A curve that was never baked is evaluated exactly instead.
+		void EvaluateBakedBatch(const float* const positions, float* const out, const size_t n);
+
+		// A curve without keys bakes to a table of 0, so lookups are always valid once baked.
+		void Bake(const int32_t resolution = DEFAULT_BAKE_RESOLUTION);
+		// Bakes if there's no table yet, or rebakes at the same resolution if keys changed since.
+		// Modules call this when a curve is set, so keys should be added before handing one over.
+		void EnsureBaked();
+		// Marks the table as out of date with the keys. Changing keys doesn't bake by itself.
+		void Invalidate();
+		void ClearBake();
+		const bool IsBaked();
+		const int32_t GetBakedResolution();
+
+		// Branch-free table lookup. Only valid once the curve has been baked.
+		inline const float EvaluateBaked(const float position) const
+		{
+			return evaluateBakedCurve(bakedWrap, baked.data(), (int32_t)baked.size() - 1, position);
+		}
+
 		void ComputeTangents(const CurveTangent::CurveTangent tangentType);
 		void ComputeTangents(const CurveTangent::CurveTangent tangentInType, const CurveTangent::CurveTangent tangentOutType);
 		void ComputeTangent(const size_t keyIndex, const CurveTangent::CurveTangent tangentType);
@@ -87,6 +201,16 @@ namespace Utility {
 	public:
 		Curve x, y, z, w;
 		const Vector4 Evaluate(const float position);
+		void EvaluateBatch(const float* const positions, float* const outX, float* const outY, float* const outZ, float* const outW, const size_t n);
+		void EvaluateBakedBatch(const float* const positions, float* const outX, float* const outY, float* const outZ, float* const outW, const size_t n);
+		void Bake(const int32_t resolution = Curve::DEFAULT_BAKE_RESOLUTION);
+		void EnsureBaked();
+
+		inline const Vector4 EvaluateBaked(const float position) const
+		{
+			return Vector4(x.EvaluateBaked(position), y.EvaluateBaked(position), z.EvaluateBaked(position), w.EvaluateBaked(position));
+		}
+
 		Curve4(Curve x, Curve y, Curve z, Curve w) : x(x), y(y), z(z), w(w) { }
 	};
 }
@@ -0,0 +1,105 @@
+#include "RadixSort.h"
+#include <string.h>
+
+namespace Utility {
+
+	namespace {
+		const int32_t DIGIT_BITS = 11;
+		const int32_t BUCKETS = 1 << DIGIT_BITS;
+		const int32_t PASSES = 3;
+
+		// Flips floats so unsigned comparison matches float order: negatives reversed, positives above them.
+		inline uint32_t sortableKey(const float key)
+		{
+			uint32_t bits;
+			memcpy(&bits, &key, sizeof(bits));
+			return bits ^ ((bits >> 31) != 0 ? 0xffffffffu : 0x80000000u);
+		}
+	}
+
+	void RadixSort::sort(const float* const keys, const int32_t length, int32_t* const order)
+	{
+		if (length <= 0)
+			return;
+
+		reserve(length);
+
+		uint32_t* const __restrict sortKeys = keyBuffer[0].data();
+		int32_t* const __restrict indices = indexBuffer[0].data();
+		for (int32_t i = 0; i < length; i++) {
+			sortKeys[i] = sortableKey(keys[i]);
+			indices[i] = i;
+		}
+		sortLoaded(length, order);
+	}
+
+	void RadixSort::sort(const float* const keys, const int32_t* const subset, const int32_t length, int32_t* const order)
+	{
+		if (length <= 0)
+			return;
+
+		reserve(length);
+
+		uint32_t* const __restrict sortKeys = keyBuffer[0].data();
+		int32_t* const __restrict indices = indexBuffer[0].data();
+		for (int32_t i = 0; i < length; i++) {
+			sortKeys[i] = sortableKey(keys[subset[i]]);
+			indices[i] = subset[i];
+		}
+		sortLoaded(length, order);
+	}
+
+	void RadixSort::reserve(const int32_t length)
+	{
+		for (int32_t b = 0; b < 2; b++) {
+			if ((int32_t)keyBuffer[b].size() < length) {
+				keyBuffer[b].resize(length);
+				indexBuffer[b].resize(length);
+			}
+		}
+	}
+
+	void RadixSort::sortLoaded(const int32_t length, int32_t* const order)
+	{
+		// All histograms come from one read of the keys.
+		histograms.assign((size_t)PASSES * BUCKETS, 0);
+		const uint32_t* const loaded = keyBuffer[0].data();
+		for (int32_t i = 0; i < length; i++) {
+			const uint32_t key = loaded[i];
+			for (int32_t pass = 0; pass < PASSES; pass++) {
+				histograms[(pass * BUCKETS) + ((key >> (pass * DIGIT_BITS)) & (BUCKETS - 1))]++;
+			}
+		}
+
+		int32_t source = 0;
+		for (int32_t pass = 0; pass < PASSES; pass++) {
+			int32_t* const counts = &histograms[pass * BUCKETS];
+			const int32_t shift = pass * DIGIT_BITS;
+			if (counts[(loaded[0] >> shift) & (BUCKETS - 1)] == length)
+				continue;
+
+			// Exclusive prefix sum: counts become the first output slot of each bucket.
+			int32_t sum = 0;
+			for (int32_t b = 0; b < BUCKETS; b++) {
+				const int32_t count = counts[b];
+				counts[b] = sum;
+				sum += count;
+			}
+
+			const uint32_t* const __restrict srcKeys = keyBuffer[source].data();
+			const int32_t* const __restrict srcIndices = indexBuffer[source].data();
+			uint32_t* const __restrict dstKeys = keyBuffer[source ^ 1].data();
+			int32_t* const __restrict dstIndices = indexBuffer[source ^ 1].data();
+			for (int32_t i = 0; i < length; i++) {
+				const uint32_t key = srcKeys[i];
+				const int32_t slot = counts[(key >> shift) & (BUCKETS - 1)]++;
+				dstKeys[slot] = key;
+				dstIndices[slot] = srcIndices[i];
+			}
+			source ^= 1;
+		}
+
+		memcpy(order, indexBuffer[source].data(), (size_t)length * sizeof(int32_t));
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,33 @@
+#pragma once
+
+#ifndef UTILITY_RADIXSORT_H
+#define UTILITY_RADIXSORT_H
+
+#include <stdint.h>
+#include <vector>
+
+namespace Utility {
+
+	// Stable LSD radix sort of float keys, producing a permutation. Three 11-bit passes over the
+	// keys mapped to order-preserving unsigned integers. Passes where every key shares the same
+	// digit are skipped, which is common for depths in a narrow range. Scratch is kept between calls.
+	class RadixSort {
+	public:
+		// order[i] = index of the i-th smallest key. Equal keys keep their index order.
+		void sort(const float* const keys, const int32_t length, int32_t* const order);
+
+		// Same, for a subset: sorts the length entries of 'subset' by keys[subset[i]].
+		void sort(const float* const keys, const int32_t* const subset, const int32_t length, int32_t* const order);
+
+	private:
+		std::vector<uint32_t> keyBuffer[2];
+		std::vector<int32_t> indexBuffer[2];
+		std::vector<int32_t> histograms;
+
+		void reserve(const int32_t length);
+		void sortLoaded(const int32_t length, int32_t* const order);
+	};
+
+}
+
+#endif
\ No newline at end of file
@@ -1,13 +1,134 @@
 #include "Random.h"
-#include <iostream>
-#include <chrono>
+#include <atomic>
 
 namespace Utility {
 
+	namespace {
+		const uint64_t GOLDEN_GAMMA = 0x9E3779B97F4A7C15ull;
+
+		// SplitMix64, used to expand a seed into generator state.
+		inline uint64_t splitMix(uint64_t& state)
+		{
+			uint64_t z = (state += GOLDEN_GAMMA);
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+			return z ^ (z >> 31);
+		}
+
+		std::atomic<uint64_t> defaultSeedCounter(0);
+	}
+
 	const float Utility::Random::range(const float& min, const float& max) {
-		static thread_local std::mt19937 generator;
-		std::uniform_real_distribution<float> distribution(min,max);
-		return distribution(generator);
+		static thread_local RandomStream generator(RandomStream::nextDefaultSeed());
+		return generator.range(min, max);
+	}
+
+	RandomStream::RandomStream()
+	{
+		seed(nextDefaultSeed());
+	}
+
+	RandomStream::RandomStream(const uint64_t seed, const uint64_t stream)
+	{
+		this->seed(seed, stream);
+	}
+
+	void RandomStream::seed(const uint64_t seed, const uint64_t stream)
+	{
+		uint64_t state = seed;
+		uint64_t streamState = stream;
+		state ^= splitMix(streamState);
+		for (int32_t lane = 0; lane < LANES; lane++) {
+			const uint64_t a = splitMix(state);
+			const uint64_t b = splitMix(state);
+			s0[lane] = (uint32_t)a;
+			s1[lane] = (uint32_t)(a >> 32);
+			s2[lane] = (uint32_t)b;
+			s3[lane] = (uint32_t)(b >> 32);
+
+			// An all-zero state would only ever produce zeros.
+			if ((s0[lane] | s1[lane] | s2[lane] | s3[lane]) == 0)
+				s0[lane] = 1;
+		}
+		cached = 0;
+	}
+
+	void RandomStream::step(float* const out)
+	{
+		uint32_t* const __restrict a = s0;
+		uint32_t* const __restrict b = s1;
+		uint32_t* const __restrict c = s2;
+		uint32_t* const __restrict d = s3;
+
+		#pragma omp simd
+		for (int32_t lane = 0; lane < LANES; lane++) {
+			const uint32_t result = a[lane] + d[lane];
+			const uint32_t t = b[lane] << 9;
+			c[lane] ^= a[lane];
+			d[lane] ^= b[lane];
+			b[lane] ^= c[lane];
+			a[lane] ^= d[lane];
+			c[lane] ^= t;
+			d[lane] = (d[lane] << 11) | (d[lane] >> 21);
+
+			// Top 24 bits, the well-mixed ones for xoshiro128+, map exactly onto float precision.
+			out[lane] = (float)(result >> 8) * (1.0f / 16777216.0f);
+		}
+	}
+
+	const float RandomStream::next()
+	{
+		if (cached == 0) {
+			step(cache);
+			cached = LANES;
+		}
+		return cache[--cached];
+	}
+
+	const float RandomStream::range(const float min, const float max)
+	{
+		return min + ((max - min) * next());
+	}
+
+	void RandomStream::fill(float* const out, const int32_t length)
+	{
+		int32_t i = 0;
+		for (; i + LANES <= length; i += LANES) {
+			step(out + i);
+		}
+		for (; i < length; i++) {
+			out[i] = next();
+		}
+	}
+
+	void RandomStream::fillRange(float* const out, const int32_t length, const float min, const float max)
+	{
+		fill(out, length);
+
+		const float delta = max - min;
+		#pragma omp simd
+		for (int32_t i = 0; i < length; i++) {
+			out[i] = min + (delta * out[i]);
+		}
+	}
+
+	void RandomStream::fillIndexed(float* const out, const int32_t* const ids, const int32_t length, const float min, const float max)
+	{
+		const int32_t blockSize = 256;
+		float values[blockSize];
+		for (int32_t blockStart = 0; blockStart < length; blockStart += blockSize) {
+			const int32_t count = (length - blockStart) < blockSize ? (length - blockStart) : blockSize;
+			fillRange(values, count, min, max);
+			for (int32_t j = 0; j < count; j++) {
+				out[ids[blockStart + j]] = values[j];
+			}
+		}
+	}
+
+	const uint64_t RandomStream::nextDefaultSeed()
+	{
+		uint64_t state = defaultSeedCounter.fetch_add(1);
+		return splitMix(state);
 	}
 
-}
+}
\ No newline at end of file
@@ -3,6 +3,7 @@
 #ifndef UTILITYRANDOM_58927_H
 #define UTILITYRANDOM_58927_H
 
+#include <stdint.h>
 #include <random>
 
 namespace Utility {
@@ -10,6 +11,39 @@ namespace Utility {
 	public:
 		static const float range(const float& min = 0.0f, const float& max = 0.0f);
 	};
+
+	// Seedable xoshiro128+ generator. LANES independent states are stepped together, so bulk
+	// fills vectorize. Streams built from the same seed with different stream indices are
+	// independent, which lets parallel chunks each draw from their own stream deterministically.
+	class RandomStream {
+	public:
+		static const int32_t LANES = 8;
+
+		RandomStream();
+		RandomStream(const uint64_t seed, const uint64_t stream = 0);
+
+		void seed(const uint64_t seed, const uint64_t stream = 0);
+
+		// Uniform in [0, 1).
+		const float next();
+		const float range(const float min, const float max);
+
+		void fill(float* const out, const int32_t length);
+		void fillRange(float* const out, const int32_t length, const float min, const float max);
+
+		// out[ids[i]] = range(min, max), for per-particle data indexed by id.
+		void fillIndexed(float* const out, const int32_t* const ids, const int32_t length, const float min, const float max);
+
+		// Distinct seed for each call, for objects that were never seeded explicitly.
+		static const uint64_t nextDefaultSeed();
+
+	private:
+		uint32_t s0[LANES], s1[LANES], s2[LANES], s3[LANES];
+		float cache[LANES];
+		int32_t cached = 0;
+
+		void step(float* const out);
+	};
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,82 @@
+#include "SimdKernels.h"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+	#include <intrin.h>
+#endif
+
+namespace Utility {
+
+	namespace {
+		SimdPath::Path detectPath()
+		{
+			const SimdPath::Path baseline = Baseline::getKernelTable().path;
+		#if defined(SIMD_VARIANTS) && defined(_MSC_VER)
+			int info[4];
+			__cpuid(info, 0);
+			const int maxLeaf = info[0];
+			__cpuid(info, 1);
+			const bool osxsave = (info[2] & (1 << 27)) != 0;
+			const bool fma = (info[2] & (1 << 12)) != 0;
+			if (maxLeaf < 7 || !osxsave)
+				return baseline;
+
+			// The OS has to save the wider registers too: YMM for AVX, plus opmask/ZMM for AVX-512.
+			const unsigned long long xcr0 = _xgetbv(0);
+			__cpuidex(info, 7, 0);
+			const bool avx2 = fma && (info[1] & (1 << 5)) != 0 && (xcr0 & 0x6) == 0x6;
+			const bool avx512 = avx2 && (info[1] & (1 << 16)) != 0 && (info[1] & (1 << 17)) != 0
+				&& (info[1] & (1 << 30)) != 0 && (info[1] & (1u << 31)) != 0 && (xcr0 & 0xe6) == 0xe6;
+		#elif defined(SIMD_VARIANTS)
+			// Also checks that the OS enabled the wider register state.
+			__builtin_cpu_init();
+			const bool avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+			const bool avx512 = avx2 && __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq")
+				&& __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vl");
+		#else
+			const bool avx2 = false;
+			const bool avx512 = false;
+		#endif
+			if (avx512)
+				return SimdPath::AVX512;
+			if (avx2)
+				return SimdPath::AVX2;
+
+			return baseline;
+		}
+
+		const KernelTable* selectTable(const SimdPath::Path path)
+		{
+		#if defined(SIMD_VARIANTS)
+			if (path >= SimdPath::AVX512)
+				return &Avx512::getKernelTable();
+			if (path >= SimdPath::AVX2)
+				return &Avx2::getKernelTable();
+		#endif
+			return &Baseline::getKernelTable();
+		}
+
+		const SimdPath::Path supportedPath = detectPath();
+		const KernelTable* activeTable = selectTable(supportedPath);
+	}
+
+	const KernelTable& SimdKernels::get()
+	{
+		return *activeTable;
+	}
+
+	const SimdPath::Path SimdKernels::getPath()
+	{
+		return activeTable->path;
+	}
+
+	const SimdPath::Path SimdKernels::getSupportedPath()
+	{
+		return supportedPath;
+	}
+
+	void SimdKernels::setPath(const SimdPath::Path path)
+	{
+		activeTable = selectTable(path < supportedPath ? path : supportedPath);
+	}
+
+}
\ No newline at end of file
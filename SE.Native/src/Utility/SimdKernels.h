@@ -0,0 +1,103 @@
+#pragma once
+
+#ifndef UTILITY_SIMDKERNELS_H
+#define UTILITY_SIMDKERNELS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "Curve.h"
+
+namespace Utility {
+
+	namespace SimdPath {
+		enum Path : int32_t { Scalar, SSE2, AVX2, AVX512 };
+	}
+
+	// View rectangle in world units, for culling.
+	struct ViewBounds {
+	public:
+		float minX, minY, maxX, maxY;
+	};
+
+	// The SoA streams culling reads. Particles are centered on their position.
+	struct ParticleBounds {
+	public:
+		const float* positionX;
+		const float* positionY;
+		const float* scaleX;
+		const float* scaleY;
+		const int32_t* rectWidth;
+		const int32_t* rectHeight;
+	};
+
+	// Hot loops, compiled once per instruction set. Packed colors are HSLA bytes from least
+	// significant, in ParticleColor units (hue 0-360, saturation/lightness 0-100, alpha 0-1).
+	struct KernelTable {
+	public:
+		SimdPath::Path path;
+
+		void (*setHue)(uint32_t* const colors, const float* const values, const int32_t length);
+		void (*setSaturation)(uint32_t* const colors, const float* const values, const int32_t length);
+		void (*setLightness)(uint32_t* const colors, const float* const values, const int32_t length);
+		void (*setAlpha)(uint32_t* const colors, const float* const values, const int32_t length);
+		void (*packColors)(const float* const hue, const float* const saturation, const float* const lightness,
+			const float* const alpha, uint32_t* const out, const int32_t length);
+
+		// out[i] = Lerp(from[ids[i]], to, amount[i]) and Lerp(from[ids[i]], to[ids[i]], amount[i]).
+		void (*lerpColors)(const uint32_t* const from, const int32_t* const ids, const uint32_t to,
+			const float* const amount, uint32_t* const out, const int32_t length);
+		void (*lerpColorsIndexed)(const uint32_t* const from, const uint32_t* const to, const int32_t* const ids,
+			const float* const amount, uint32_t* const out, const int32_t length);
+
+		// Lerps one 8-bit channel of packed start colors, converted to float units (byte / 255 * scale):
+		// out[i] = Lerp(channel(from[ids[i]]), to, amount[i]), and with a per-particle random end
+		// to = min + (max - min) * random[ids[i]].
+		void (*lerpChannel)(const uint32_t* const from, const int32_t* const ids, const int32_t shift, const float scale,
+			const float to, const float* const amount, float* const out, const int32_t length);
+		void (*lerpChannelRandom)(const uint32_t* const from, const int32_t* const ids, const int32_t shift, const float scale,
+			const float min, const float max, const float* const random, const float* const amount, float* const out, const int32_t length);
+
+		void (*evaluateBakedCurve)(const CurveWrap& wrap, const float* const values, const int32_t lastIndex,
+			const float* const positions, float* const out, const size_t length);
+		void (*evaluateCurve)(const CurveWrap& wrap, const CurveKeyArrays& keys,
+			const float* const positions, float* const out, const size_t length);
+
+		// Dead particle removal. The live mask has one bit per element (bit i % 8 of byte i / 8),
+		// set where timeAlive < initialLife, with the bits past length cleared. Both return the
+		// live count. compact() moves the live elements of one 4-byte stream to the front, in order.
+		int32_t (*buildLiveMask)(const float* const timeAlive, const float* const initialLife, uint8_t* const liveMask, const int32_t length);
+		int32_t (*compact)(uint32_t* const data, const uint8_t* const liveMask, const int32_t length);
+
+		// Camera culling, with the same bit layout as the live mask. A particle is visible when the
+		// box around its bounding circle overlaps the view. Returns the visible count.
+		int32_t (*buildVisibleMask)(const ParticleBounds& particles, const ViewBounds& view, uint8_t* const visibleMask, const int32_t length);
+
+		// Floats to IEEE half floats, rounding to nearest even.
+		void (*toHalves)(const float* const values, uint16_t* const out, const int32_t length);
+
+		// Packed HSLA to RGBA8 (red in the low byte), the same conversion as the particle shader's hsl2rgb.
+		void (*toRgba)(const uint32_t* const colors, uint32_t* const out, const int32_t length);
+	};
+
+	// Picks the best kernel variant the CPU supports (cpuid) when the library loads.
+	class SimdKernels {
+	public:
+		static const KernelTable& get();
+		static const SimdPath::Path getPath();
+		static const SimdPath::Path getSupportedPath();
+
+		// Forces a lower path, e.g. to compare variants. Clamped to the supported path.
+		// Not safe while updates are running.
+		static void setPath(const SimdPath::Path path);
+	};
+
+	// One per compiled variant (SimdKernelsImpl.cpp). Baseline uses the library's own flags.
+	namespace Baseline { const KernelTable& getKernelTable(); }
+#if defined(SIMD_VARIANTS)
+	namespace Avx2 { const KernelTable& getKernelTable(); }
+	namespace Avx512 { const KernelTable& getKernelTable(); }
+#endif
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,647 @@
+// Compiled once with the library's flags (namespace Baseline) and, on x86, again with AVX2 and
+// AVX-512 flags (SIMD_VARIANT=Avx2/Avx512, see CMakeLists.txt). Everything here must have
+// internal linkage or live in the variant namespace. Calling a shared inline function from
+// another header would emit a copy built for this instruction set that the linker may pick for
+// the whole library.
+#include "SimdKernels.h"
+#include <math.h>
+#include <string.h>
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+	#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+#endif
+
+#ifndef SIMD_VARIANT
+	#define SIMD_VARIANT Baseline
+#endif
+
+namespace Utility {
+	namespace SIMD_VARIANT {
+
+	namespace {
+		// Channel shifts inside the packed value.
+		const int HUE = 0;
+		const int SATURATION = 8;
+		const int LIGHTNESS = 16;
+		const int ALPHA = 24;
+
+		// Channel units to byte range.
+		const float HUE_SCALE = 255.0f / 360.0f;
+		const float PERCENT_SCALE = 255.0f / 100.0f;
+		const float ALPHA_SCALE = 255.0f;
+
+		// Positions are evaluated in blocks so the per-lane scratch stays on the stack.
+		const size_t CURVE_BATCH_BLOCK = 256;
+
+		inline int32_t popCount(uint32_t v)
+		{
+			v = v - ((v >> 1) & 0x55555555u);
+			v = (v & 0x33333333u) + ((v >> 2) & 0x33333333u);
+			return (int32_t)((((v + (v >> 4)) & 0x0f0f0f0fu) * 0x01010101u) >> 24);
+		}
+
+		// IEEE half with round to nearest even, like F16C. Branchless so the loop vectorizes.
+		inline uint16_t toHalf(const float value)
+		{
+			uint32_t bits;
+			memcpy(&bits, &value, sizeof(bits));
+			const uint32_t sign = (bits >> 16) & 0x8000u;
+			const uint32_t magnitude = bits & 0x7fffffffu;
+
+			// Normal range: rebias the exponent and round away the low 13 mantissa bits.
+			uint32_t normal = (magnitude - 0x38000000u) >> 13;
+			const uint32_t normalRest = magnitude & 0x1fffu;
+			normal += (normalRest > 0x1000u || (normalRest == 0x1000u && (normal & 1u))) ? 1u : 0u;
+
+			// Below 2^-14: half subnormals, in units of 2^-24.
+			const int32_t exponent = (int32_t)(magnitude >> 23);
+			const uint32_t shift = (uint32_t)(126 - exponent < 31 ? 126 - exponent : 31);
+			const uint32_t mantissa = (magnitude & 0x7fffffu) | 0x800000u;
+			uint32_t subnormal = mantissa >> shift;
+			const uint32_t subnormalRest = mantissa & ((1u << shift) - 1u);
+			const uint32_t halfway = 1u << (shift - 1u);
+			subnormal += (subnormalRest > halfway || (subnormalRest == halfway && (subnormal & 1u))) ? 1u : 0u;
+
+			uint32_t result = magnitude < 0x38800000u ? subnormal : normal;
+			result = magnitude >= 0x477ff000u ? 0x7c00u : result;						// Rounds past 65504: infinity.
+			result = magnitude > 0x7f800000u ? (0x7e00u | ((magnitude >> 13) & 0x3ffu)) : result;	// Quiet NaN.
+			return (uint16_t)(sign | result);
+		}
+
+		inline uint32_t maskBit(const uint8_t* const mask, const int32_t i)
+		{
+			return (mask[i >> 3] >> (i & 7)) & 1u;
+		}
+
+		// Scalar versions, also used for the tails of the vector loops. NaN maps to 0.
+		inline uint32_t toByte(const float value)
+		{
+			return (uint32_t)(value > 0.0f ? (value < 255.0f ? value : 255.0f) : 0.0f);
+		}
+
+		// One RGB channel of the particle shader's hsl2rgb, rounded to a byte. 'offset' is 0, 4 or 2 for
+		// red, green and blue. The vector version below does the same operations in the same order.
+		inline uint32_t rgbChannel(const float hue, const float offset, const float lightness, const float chroma)
+		{
+			float t = (hue * 6.0f) + offset;
+			t = t - (6.0f * (float)(int32_t)(t * (1.0f / 6.0f)));
+			float weight = fabsf(t - 3.0f) - 1.0f;
+			weight = weight > 0.0f ? (weight < 1.0f ? weight : 1.0f) : 0.0f;
+			return toByte(((lightness + (chroma * (weight - 0.5f))) * 255.0f) + 0.5f);
+		}
+
+		inline uint32_t hslaToRgba(const uint32_t color)
+		{
+			const float hue = (float)((color >> HUE) & 0xff) * (1.0f / 255.0f);
+			const float saturation = (float)((color >> SATURATION) & 0xff) * (1.0f / 255.0f);
+			const float lightness = (float)((color >> LIGHTNESS) & 0xff) * (1.0f / 255.0f);
+			const float darkness = 1.0f - lightness;
+			const float nearest = lightness > 0.0f ? (lightness < darkness ? lightness : darkness) : 0.0f;
+			const float chroma = saturation * (nearest + nearest);
+			return rgbChannel(hue, 0.0f, lightness, chroma)
+				| (rgbChannel(hue, 4.0f, lightness, chroma) << 8)
+				| (rgbChannel(hue, 2.0f, lightness, chroma) << 16)
+				| (color & 0xff000000u);
+		}
+
+		inline uint32_t lerpChannel(const uint32_t from, const uint32_t to, const int shift, const float amount)
+		{
+			const float a = (float)((from >> shift) & 0xff);
+			const float b = (float)((to >> shift) & 0xff);
+			return (uint32_t)(a + (b - a) * amount) << shift;
+		}
+
+		inline uint32_t lerpColor(const uint32_t from, const uint32_t to, float amount)
+		{
+			amount = amount > 0.0f ? (amount < 1.0f ? amount : 1.0f) : 0.0f;
+			return lerpChannel(from, to, HUE, amount) | lerpChannel(from, to, SATURATION, amount)
+				| lerpChannel(from, to, LIGHTNESS, amount) | lerpChannel(from, to, ALPHA, amount);
+		}
+
+	#if defined(__AVX512F__)
+		#define SIMD_PATH SimdPath::AVX512
+		#define SIMD_VECTOR
+		const int32_t WIDTH = 16;
+		typedef __m512 VFloat;
+		typedef __m512i VInt;
+
+		inline VFloat loadFloat(const float* const ptr) { return _mm512_loadu_ps(ptr); }
+		inline VInt loadInt(const uint32_t* const ptr) { return _mm512_loadu_si512(ptr); }
+		inline void storeInt(uint32_t* const ptr, const VInt v) { _mm512_storeu_si512(ptr, v); }
+		inline VFloat splatFloat(const float v) { return _mm512_set1_ps(v); }
+		inline VInt splatInt(const uint32_t v) { return _mm512_set1_epi32((int)v); }
+		inline VFloat add(const VFloat a, const VFloat b) { return _mm512_add_ps(a, b); }
+		inline VFloat sub(const VFloat a, const VFloat b) { return _mm512_sub_ps(a, b); }
+		inline VFloat mul(const VFloat a, const VFloat b) { return _mm512_mul_ps(a, b); }
+		inline VFloat squareRoot(const VFloat v) { return _mm512_sqrt_ps(v); }
+		inline VFloat absolute(const VFloat v) { return _mm512_abs_ps(v); }
+		inline VFloat clamp(const VFloat v, const VFloat min, const VFloat max) { return _mm512_min_ps(_mm512_max_ps(v, min), max); }
+		inline VInt toInt(const VFloat v) { return _mm512_cvttps_epi32(v); }
+		inline VFloat toFloat(const VInt v) { return _mm512_cvtepi32_ps(v); }
+		inline VInt bitAnd(const VInt a, const VInt b) { return _mm512_and_si512(a, b); }
+		inline VInt bitOr(const VInt a, const VInt b) { return _mm512_or_si512(a, b); }
+		template<int SHIFT> inline VInt shiftLeft(const VInt v) { return _mm512_slli_epi32(v, SHIFT); }
+		template<int SHIFT> inline VInt shiftRight(const VInt v) { return _mm512_srli_epi32(v, SHIFT); }
+
+		inline VInt gather(const uint32_t* const base, const int32_t* const ids)
+		{
+			return _mm512_i32gather_epi32(_mm512_loadu_si512(ids), (const int*)base, 4);
+		}
+
+		// One bit per lane, lane 0 lowest.
+		inline uint32_t lessThanMask(const VFloat a, const VFloat b) { return (uint32_t)_mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+	#elif defined(__AVX2__)
+		#define SIMD_PATH SimdPath::AVX2
+		#define SIMD_VECTOR
+		const int32_t WIDTH = 8;
+		typedef __m256 VFloat;
+		typedef __m256i VInt;
+
+		inline VFloat loadFloat(const float* const ptr) { return _mm256_loadu_ps(ptr); }
+		inline VInt loadInt(const uint32_t* const ptr) { return _mm256_loadu_si256((const __m256i*)ptr); }
+		inline void storeInt(uint32_t* const ptr, const VInt v) { _mm256_storeu_si256((__m256i*)ptr, v); }
+		inline VFloat splatFloat(const float v) { return _mm256_set1_ps(v); }
+		inline VInt splatInt(const uint32_t v) { return _mm256_set1_epi32((int)v); }
+		inline VFloat add(const VFloat a, const VFloat b) { return _mm256_add_ps(a, b); }
+		inline VFloat sub(const VFloat a, const VFloat b) { return _mm256_sub_ps(a, b); }
+		inline VFloat mul(const VFloat a, const VFloat b) { return _mm256_mul_ps(a, b); }
+		inline VFloat squareRoot(const VFloat v) { return _mm256_sqrt_ps(v); }
+		inline VFloat absolute(const VFloat v) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), v); }
+		inline VFloat clamp(const VFloat v, const VFloat min, const VFloat max) { return _mm256_min_ps(_mm256_max_ps(v, min), max); }
+		inline VInt toInt(const VFloat v) { return _mm256_cvttps_epi32(v); }
+		inline VFloat toFloat(const VInt v) { return _mm256_cvtepi32_ps(v); }
+		inline VInt bitAnd(const VInt a, const VInt b) { return _mm256_and_si256(a, b); }
+		inline VInt bitOr(const VInt a, const VInt b) { return _mm256_or_si256(a, b); }
+		template<int SHIFT> inline VInt shiftLeft(const VInt v) { return _mm256_slli_epi32(v, SHIFT); }
+		template<int SHIFT> inline VInt shiftRight(const VInt v) { return _mm256_srli_epi32(v, SHIFT); }
+
+		inline VInt gather(const uint32_t* const base, const int32_t* const ids)
+		{
+			return _mm256_i32gather_epi32((const int*)base, _mm256_loadu_si256((const __m256i*)ids), 4);
+		}
+
+		inline uint32_t lessThanMask(const VFloat a, const VFloat b) { return (uint32_t)_mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_LT_OQ)); }
+	#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+		#define SIMD_PATH SimdPath::SSE2
+		#define SIMD_VECTOR
+		const int32_t WIDTH = 4;
+		typedef __m128 VFloat;
+		typedef __m128i VInt;
+
+		inline VFloat loadFloat(const float* const ptr) { return _mm_loadu_ps(ptr); }
+		inline VInt loadInt(const uint32_t* const ptr) { return _mm_loadu_si128((const __m128i*)ptr); }
+		inline void storeInt(uint32_t* const ptr, const VInt v) { _mm_storeu_si128((__m128i*)ptr, v); }
+		inline VFloat splatFloat(const float v) { return _mm_set1_ps(v); }
+		inline VInt splatInt(const uint32_t v) { return _mm_set1_epi32((int)v); }
+		inline VFloat add(const VFloat a, const VFloat b) { return _mm_add_ps(a, b); }
+		inline VFloat sub(const VFloat a, const VFloat b) { return _mm_sub_ps(a, b); }
+		inline VFloat mul(const VFloat a, const VFloat b) { return _mm_mul_ps(a, b); }
+		inline VFloat squareRoot(const VFloat v) { return _mm_sqrt_ps(v); }
+		inline VFloat absolute(const VFloat v) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), v); }
+		inline VFloat clamp(const VFloat v, const VFloat min, const VFloat max) { return _mm_min_ps(_mm_max_ps(v, min), max); }
+		inline VInt toInt(const VFloat v) { return _mm_cvttps_epi32(v); }
+		inline VFloat toFloat(const VInt v) { return _mm_cvtepi32_ps(v); }
+		inline VInt bitAnd(const VInt a, const VInt b) { return _mm_and_si128(a, b); }
+		inline VInt bitOr(const VInt a, const VInt b) { return _mm_or_si128(a, b); }
+		template<int SHIFT> inline VInt shiftLeft(const VInt v) { return _mm_slli_epi32(v, SHIFT); }
+		template<int SHIFT> inline VInt shiftRight(const VInt v) { return _mm_srli_epi32(v, SHIFT); }
+
+		// No gather instruction before AVX2.
+		inline VInt gather(const uint32_t* const base, const int32_t* const ids)
+		{
+			return _mm_setr_epi32((int)base[ids[0]], (int)base[ids[1]], (int)base[ids[2]], (int)base[ids[3]]);
+		}
+
+		inline uint32_t lessThanMask(const VFloat a, const VFloat b) { return (uint32_t)_mm_movemask_ps(_mm_cmplt_ps(a, b)); }
+	#else
+		#define SIMD_PATH SimdPath::Scalar
+	#endif
+
+	#if defined(SIMD_VECTOR)
+		// Scaled floats to bytes. max(v, 0) picks 0 for NaN, like the scalar toByte().
+		inline VInt toBytes(const VFloat values, const VFloat scale)
+		{
+			return toInt(clamp(mul(values, scale), splatFloat(0.0f), splatFloat(255.0f)));
+		}
+
+		template<int SHIFT>
+		inline VInt lerpChannel(const VInt from, const VInt to, const VFloat amount)
+		{
+			const VInt mask = splatInt(0xff);
+			const VFloat a = toFloat(bitAnd(shiftRight<SHIFT>(from), mask));
+			const VFloat b = toFloat(bitAnd(shiftRight<SHIFT>(to), mask));
+			return shiftLeft<SHIFT>(toInt(add(a, mul(sub(b, a), amount))));
+		}
+
+		inline VInt rgbChannel(const VFloat hue, const VFloat offset, const VFloat lightness, const VFloat chroma)
+		{
+			const VFloat zero = splatFloat(0.0f);
+			const VFloat one = splatFloat(1.0f);
+			VFloat t = add(mul(hue, splatFloat(6.0f)), offset);
+			t = sub(t, mul(splatFloat(6.0f), toFloat(toInt(mul(t, splatFloat(1.0f / 6.0f))))));
+			const VFloat weight = clamp(sub(absolute(sub(t, splatFloat(3.0f))), one), zero, one);
+			const VFloat value = add(mul(add(lightness, mul(chroma, sub(weight, splatFloat(0.5f)))), splatFloat(255.0f)), splatFloat(0.5f));
+			return toInt(clamp(value, zero, splatFloat(255.0f)));
+		}
+
+		inline VInt hslaToRgba(const VInt color)
+		{
+			const VInt mask = splatInt(0xff);
+			const VFloat inverse = splatFloat(1.0f / 255.0f);
+			const VFloat hue = mul(toFloat(bitAnd(shiftRight<HUE>(color), mask)), inverse);
+			const VFloat saturation = mul(toFloat(bitAnd(shiftRight<SATURATION>(color), mask)), inverse);
+			const VFloat lightness = mul(toFloat(bitAnd(shiftRight<LIGHTNESS>(color), mask)), inverse);
+			const VFloat nearest = clamp(lightness, splatFloat(0.0f), sub(splatFloat(1.0f), lightness));
+			const VFloat chroma = mul(saturation, add(nearest, nearest));
+			return bitOr(bitOr(rgbChannel(hue, splatFloat(0.0f), lightness, chroma),
+				shiftLeft<8>(rgbChannel(hue, splatFloat(4.0f), lightness, chroma))),
+				bitOr(shiftLeft<16>(rgbChannel(hue, splatFloat(2.0f), lightness, chroma)), bitAnd(color, splatInt(0xff000000u))));
+		}
+
+		inline VInt lerpColor(const VInt from, const VInt to, VFloat amount)
+		{
+			amount = clamp(amount, splatFloat(0.0f), splatFloat(1.0f));
+			return bitOr(bitOr(lerpChannel<HUE>(from, to, amount), lerpChannel<SATURATION>(from, to, amount)),
+				bitOr(lerpChannel<LIGHTNESS>(from, to, amount), lerpChannel<ALPHA>(from, to, amount)));
+		}
+	#endif
+
+		template<int SHIFT>
+		void setChannel(uint32_t* const packed, const float* const values, const float scale, const int32_t length)
+		{
+			const uint32_t keep = ~(0xffu << SHIFT);
+			int32_t i = 0;
+		#if defined(SIMD_VECTOR)
+			const VFloat vScale = splatFloat(scale);
+			const VInt vKeep = splatInt(keep);
+			for (; i + WIDTH <= length; i += WIDTH) {
+				const VInt bytes = toBytes(loadFloat(values + i), vScale);
+				storeInt(packed + i, bitOr(bitAnd(loadInt(packed + i), vKeep), shiftLeft<SHIFT>(bytes)));
+			}
+		#endif
+			for (; i < length; i++) {
+				packed[i] = (packed[i] & keep) | (toByte(values[i] * scale) << SHIFT);
+			}
+		}
+
+		void setHue(uint32_t* const colors, const float* const values, const int32_t length)
+		{
+			setChannel<HUE>(colors, values, HUE_SCALE, length);
+		}
+
+		void setSaturation(uint32_t* const colors, const float* const values, const int32_t length)
+		{
+			setChannel<SATURATION>(colors, values, PERCENT_SCALE, length);
+		}
+
+		void setLightness(uint32_t* const colors, const float* const values, const int32_t length)
+		{
+			setChannel<LIGHTNESS>(colors, values, PERCENT_SCALE, length);
+		}
+
+		void setAlpha(uint32_t* const colors, const float* const values, const int32_t length)
+		{
+			setChannel<ALPHA>(colors, values, ALPHA_SCALE, length);
+		}
+
+		void packColors(const float* const hue, const float* const saturation, const float* const lightness,
+			const float* const alpha, uint32_t* const out, const int32_t length)
+		{
+			int32_t i = 0;
+		#if defined(SIMD_VECTOR)
+			const VFloat hueScale = splatFloat(HUE_SCALE);
+			const VFloat percentScale = splatFloat(PERCENT_SCALE);
+			const VFloat alphaScale = splatFloat(ALPHA_SCALE);
+			for (; i + WIDTH <= length; i += WIDTH) {
+				const VInt h = toBytes(loadFloat(hue + i), hueScale);
+				const VInt s = shiftLeft<SATURATION>(toBytes(loadFloat(saturation + i), percentScale));
+				const VInt l = shiftLeft<LIGHTNESS>(toBytes(loadFloat(lightness + i), percentScale));
+				const VInt a = shiftLeft<ALPHA>(toBytes(loadFloat(alpha + i), alphaScale));
+				storeInt(out + i, bitOr(bitOr(h, s), bitOr(l, a)));
+			}
+		#endif
+			for (; i < length; i++) {
+				out[i] = toByte(hue[i] * HUE_SCALE)
+					| (toByte(saturation[i] * PERCENT_SCALE) << SATURATION)
+					| (toByte(lightness[i] * PERCENT_SCALE) << LIGHTNESS)
+					| (toByte(alpha[i] * ALPHA_SCALE) << ALPHA);
+			}
+		}
+
+		void toRgba(const uint32_t* const colors, uint32_t* const out, const int32_t length)
+		{
+			int32_t i = 0;
+		#if defined(SIMD_VECTOR)
+			for (; i + WIDTH <= length; i += WIDTH) {
+				storeInt(out + i, hslaToRgba(loadInt(colors + i)));
+			}
+		#endif
+			for (; i < length; i++) {
+				out[i] = hslaToRgba(colors[i]);
+			}
+		}
+
+		void lerpColors(const uint32_t* const from, const int32_t* const ids, const uint32_t to,
+			const float* const amount, uint32_t* const out, const int32_t length)
+		{
+			int32_t i = 0;
+		#if defined(SIMD_VECTOR)
+			const VInt vTo = splatInt(to);
+			for (; i + WIDTH <= length; i += WIDTH) {
+				storeInt(out + i, lerpColor(gather(from, ids + i), vTo, loadFloat(amount + i)));
+			}
+		#endif
+			for (; i < length; i++) {
+				out[i] = lerpColor(from[ids[i]], to, amount[i]);
+			}
+		}
+
+		void lerpColorsIndexed(const uint32_t* const from, const uint32_t* const to, const int32_t* const ids,
+			const float* const amount, uint32_t* const out, const int32_t length)
+		{
+			int32_t i = 0;
+		#if defined(SIMD_VECTOR)
+			for (; i + WIDTH <= length; i += WIDTH) {
+				storeInt(out + i, lerpColor(gather(from, ids + i), gather(to, ids + i), loadFloat(amount + i)));
+			}
+		#endif
+			for (; i < length; i++) {
+				const int32_t pId = ids[i];
+				out[i] = lerpColor(from[pId], to[pId], amount[i]);
+			}
+		}
+
+		void lerpChannel(const uint32_t* const from, const int32_t* const ids, const int32_t shift, const float scale,
+			const float to, const float* const amount, float* const out, const int32_t length)
+		{
+			float* const __restrict dst = out;
+
+			#pragma omp simd
+			for (int32_t i = 0; i < length; i++) {
+				const float value = ((float)((from[ids[i]] >> shift) & 0xff) / 255.0f) * scale;
+				dst[i] = value + (to - value) * amount[i];
+			}
+		}
+
+		void lerpChannelRandom(const uint32_t* const from, const int32_t* const ids, const int32_t shift, const float scale,
+			const float min, const float max, const float* const random, const float* const amount, float* const out, const int32_t length)
+		{
+			float* const __restrict dst = out;
+			const float delta = max - min;
+
+			#pragma omp simd
+			for (int32_t i = 0; i < length; i++) {
+				const int32_t pId = ids[i];
+				const float value = ((float)((from[pId] >> shift) & 0xff) / 255.0f) * scale;
+				const float to = min + (delta * random[pId]);
+				dst[i] = value + (to - value) * amount[i];
+			}
+		}
+
+		int32_t buildLiveMask(const float* const timeAlive, const float* const initialLife, uint8_t* const liveMask, const int32_t length)
+		{
+			int32_t live = 0;
+			int32_t i = 0;
+		#if defined(SIMD_VECTOR)
+			// Whole mask bytes per step, which is two vectors on SSE2 and one on AVX2/AVX-512.
+			const int32_t step = WIDTH > 8 ? WIDTH : 8;
+			for (; i + step <= length; i += step) {
+				uint32_t bits = 0;
+				for (int32_t j = 0; j < step; j += WIDTH) {
+					bits |= lessThanMask(loadFloat(timeAlive + i + j), loadFloat(initialLife + i + j)) << j;
+				}
+				for (int32_t b = 0; b < step; b += 8) {
+					liveMask[(i + b) >> 3] = (uint8_t)(bits >> b);
+				}
+				live += popCount(bits);
+			}
+		#endif
+			// Tail bits past the length stay clear.
+			for (int32_t b = i >> 3; b < (length + 7) >> 3; b++) {
+				liveMask[b] = 0;
+			}
+			for (; i < length; i++) {
+				const uint32_t alive = timeAlive[i] < initialLife[i] ? 1u : 0u;
+				liveMask[i >> 3] |= (uint8_t)(alive << (i & 7));
+				live += (int32_t)alive;
+			}
+			return live;
+		}
+
+		int32_t compact(uint32_t* const data, const uint8_t* const liveMask, const int32_t length)
+		{
+			// In place: the write cursor never passes the read cursor, and a vector store at the
+			// write cursor ends at or before the end of the block just loaded.
+			int32_t count = 0;
+			int32_t i = 0;
+		#if defined(__AVX512F__)
+			for (; i + 16 <= length; i += 16) {
+				const uint32_t bits = liveMask[i >> 3] | ((uint32_t)liveMask[(i >> 3) + 1] << 8);
+				if (bits == 0xffffu && count == i) {
+					count += 16;
+					continue;
+				}
+				_mm512_mask_compressstoreu_epi32(data + count, (__mmask16)bits, loadInt(data + i));
+				count += popCount(bits);
+			}
+		#elif defined(__AVX2__)
+			// Lane permutation per mask byte. Built on first use, so only AVX2 machines run it.
+			struct CompressTable {
+				uint8_t lanes[256][8];
+				CompressTable()
+				{
+					for (int32_t bits = 0; bits < 256; bits++) {
+						int32_t lane = 0;
+						for (int32_t j = 0; j < 8; j++) {
+							if (bits & (1 << j))
+								lanes[bits][lane++] = (uint8_t)j;
+						}
+						for (; lane < 8; lane++) {
+							lanes[bits][lane] = 0;
+						}
+					}
+				}
+			};
+			static const CompressTable table;
+			for (; i + 8 <= length; i += 8) {
+				const uint32_t bits = liveMask[i >> 3];
+				if (bits == 0xffu && count == i) {
+					count += 8;
+					continue;
+				}
+				const __m256i lanes = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)table.lanes[bits]));
+				storeInt(data + count, _mm256_permutevar8x32_epi32(loadInt(data + i), lanes));
+				count += popCount(bits);
+			}
+		#endif
+			// Branchless: every element is written, the cursor only advances for live ones.
+			for (; i < length; i++) {
+				if ((i & 7) == 0 && i + 8 <= length && liveMask[i >> 3] == 0xff && count == i) {
+					count += 8;
+					i += 7;
+					continue;
+				}
+				data[count] = data[i];
+				count += (int32_t)maskBit(liveMask, i);
+			}
+			return count;
+		}
+
+		int32_t buildVisibleMask(const ParticleBounds& particles, const ViewBounds& view, uint8_t* const visibleMask, const int32_t length)
+		{
+			// Bounding circle of the rotated sprite: half the diagonal of the scaled source rectangle.
+			// A particle is culled only when that circle's box is fully outside the view, so NaNs stay visible.
+			int32_t visible = 0;
+			int32_t i = 0;
+		#if defined(SIMD_VECTOR)
+			const VFloat half = splatFloat(0.5f);
+			const VFloat minX = splatFloat(view.minX), minY = splatFloat(view.minY);
+			const VFloat maxX = splatFloat(view.maxX), maxY = splatFloat(view.maxY);
+			const uint32_t lanes = (uint32_t)((1ull << WIDTH) - 1);
+			const int32_t step = WIDTH > 8 ? WIDTH : 8;
+			for (; i + step <= length; i += step) {
+				uint32_t bits = 0;
+				for (int32_t j = 0; j < step; j += WIDTH) {
+					const int32_t k = i + j;
+					const VFloat width = mul(toFloat(loadInt((const uint32_t*)particles.rectWidth + k)), loadFloat(particles.scaleX + k));
+					const VFloat height = mul(toFloat(loadInt((const uint32_t*)particles.rectHeight + k)), loadFloat(particles.scaleY + k));
+					const VFloat radius = mul(half, squareRoot(add(mul(width, width), mul(height, height))));
+					const VFloat x = loadFloat(particles.positionX + k);
+					const VFloat y = loadFloat(particles.positionY + k);
+					const uint32_t culled = lessThanMask(add(x, radius), minX) | lessThanMask(maxX, sub(x, radius))
+						| lessThanMask(add(y, radius), minY) | lessThanMask(maxY, sub(y, radius));
+					bits |= (~culled & lanes) << j;
+				}
+				for (int32_t b = 0; b < step; b += 8) {
+					visibleMask[(i + b) >> 3] = (uint8_t)(bits >> b);
+				}
+				visible += popCount(bits);
+			}
+		#endif
+			for (int32_t b = i >> 3; b < (length + 7) >> 3; b++) {
+				visibleMask[b] = 0;
+			}
+			for (; i < length; i++) {
+				const float width = (float)particles.rectWidth[i] * particles.scaleX[i];
+				const float height = (float)particles.rectHeight[i] * particles.scaleY[i];
+				const float radius = 0.5f * sqrtf((width * width) + (height * height));
+				const float x = particles.positionX[i];
+				const float y = particles.positionY[i];
+				const bool culled = (x + radius < view.minX) || (view.maxX < x - radius)
+					|| (y + radius < view.minY) || (view.maxY < y - radius);
+				visibleMask[i >> 3] |= (uint8_t)((culled ? 0u : 1u) << (i & 7));
+				visible += culled ? 0 : 1;
+			}
+			return visible;
+		}
+
+		void toHalves(const float* const values, uint16_t* const out, const int32_t length)
+		{
+			const float* const __restrict src = values;
+			uint16_t* const __restrict dst = out;
+
+			#pragma omp simd
+			for (int32_t i = 0; i < length; i++) {
+				dst[i] = toHalf(src[i]);
+			}
+		}
+
+		void evaluateBakedCurveBatch(const CurveWrap& wrap, const float* const values, const int32_t lastIndex,
+			const float* const positions, float* const out, const size_t length)
+		{
+			const CurveWrap localWrap = wrap;
+			const float* const __restrict src = positions;
+			float* const __restrict dst = out;
+
+			#pragma omp simd
+			for (size_t i = 0; i < length; i++) {
+				dst[i] = evaluateBakedCurve(localWrap, values, lastIndex, src[i]);
+			}
+		}
+
+		void evaluateCurveBatch(const CurveWrap& wrap, const CurveKeyArrays& keys,
+			const float* const positions, float* const out, const size_t length)
+		{
+			const CurveWrap localWrap = wrap;
+			const float* const __restrict keyPos = keys.position;
+			const float* const __restrict keyValue = keys.value;
+			const float* const __restrict keyTangentIn = keys.tangentIn;
+			const float* const __restrict keyTangentOut = keys.tangentOut;
+			const float* const __restrict keyStep = keys.step;
+
+			// Segment s spans keys [s, s + 1]. Binary search steps over [0, lastSegment].
+			const int32_t lastSegment = keys.count - 2;
+			int32_t topStep = 1;
+			while ((topStep << 1) <= lastSegment)
+				topStep <<= 1;
+
+			float pos[CURVE_BATCH_BLOCK];
+			float extra[CURVE_BATCH_BLOCK];
+			int32_t segment[CURVE_BATCH_BLOCK];
+			for (size_t blockStart = 0; blockStart < length; blockStart += CURVE_BATCH_BLOCK) {
+				const size_t count = (length - blockStart) < CURVE_BATCH_BLOCK ? (length - blockStart) : CURVE_BATCH_BLOCK;
+				const float* const __restrict blockSrc = positions + blockStart;
+				float* const __restrict blockDst = out + blockStart;
+
+				#pragma omp simd
+				for (size_t j = 0; j < count; j++) {
+					float t;
+					wrapCurvePosition(localWrap, blockSrc[j], pos[j], t, extra[j]);
+					segment[j] = 0;
+				}
+
+				// Branch-free binary search: the last segment whose end key lies before the position.
+				for (int32_t step = topStep; step > 0; step >>= 1) {
+					#pragma omp simd
+					for (size_t j = 0; j < count; j++) {
+						const int32_t probe = segment[j] + step;
+						const int32_t clampedProbe = probe < lastSegment ? probe : lastSegment;
+						segment[j] = (probe <= lastSegment && keyPos[clampedProbe] < pos[j]) ? probe : segment[j];
+					}
+				}
+
+				// Hermite across lanes. See Curve::GetCurvePosition().
+				#pragma omp simd
+				for (size_t j = 0; j < count; j++) {
+					const int32_t prev = segment[j];
+					const int32_t next = prev + 1;
+					const float p = pos[j];
+					const float t = (p - keyPos[prev]) / (keyPos[next] - keyPos[prev]);
+					const float ts = t * t;
+					const float tss = ts * t;
+					const float hermite = (2 * tss - 3 * ts + 1.0f) * keyValue[prev] + (tss - 2 * ts + t) * keyTangentOut[prev] + (3 * ts - 2 * tss) * keyValue[next] + (tss - ts) * keyTangentIn[next];
+					const float stepped = p >= 1.0f ? keyValue[next] : keyValue[prev];
+					blockDst[j] = (keyStep[prev] != 0.0f ? stepped : hermite) + extra[j];
+				}
+			}
+		}
+	}
+
+	const KernelTable& getKernelTable()
+	{
+		static const KernelTable table = {
+			SIMD_PATH,
+			&setHue,
+			&setSaturation,
+			&setLightness,
+			&setAlpha,
+			&packColors,
+			&lerpColors,
+			&lerpColorsIndexed,
+			&lerpChannel,
+			&lerpChannelRandom,
+			&evaluateBakedCurveBatch,
+			&evaluateCurveBatch,
+			&buildLiveMask,
+			&compact,
+			&buildVisibleMask,
+			&toHalves,
+			&toRgba
+		};
+		return table;
+	}
+
+	}
+}
\ No newline at end of file
@@ -0,0 +1,220 @@
+#include "ThreadPool.h"
+
+namespace Utility {
+
+	namespace {
+		// Index of the pool worker running on this thread, or -1 for outside threads.
+		thread_local int32_t currentWorker = -1;
+
+		// Upper bound on tasks per parallelFor, relative to the thread count. Enough slack for
+		// stealing to even out imbalanced ranges without drowning in tiny tasks.
+		const int32_t TASKS_PER_THREAD = 4;
+	}
+
+	ThreadPool& ThreadPool::get()
+	{
+		// Intentionally leaked. Joining threads from a static destructor can deadlock on library unload.
+		static ThreadPool* pool = new ThreadPool();
+		return *pool;
+	}
+
+	ThreadPool::ThreadPool() : pending(0), nextQueue(0), minGrainSize(DEFAULT_MIN_GRAIN_SIZE)
+	{
+		start((int32_t)std::thread::hardware_concurrency());
+	}
+
+	const int32_t ThreadPool::getThreadCount()
+	{
+		return threadCount;
+	}
+
+	void ThreadPool::setThreadCount(const int32_t count)
+	{
+		// Not safe while a parallelFor is in flight.
+		stop();
+		start(count <= 0 ? (int32_t)std::thread::hardware_concurrency() : count);
+	}
+
+	const int32_t ThreadPool::getMinGrainSize()
+	{
+		return minGrainSize.load();
+	}
+
+	void ThreadPool::setMinGrainSize(const int32_t size)
+	{
+		minGrainSize.store(size < 1 ? 1 : size);
+	}
+
+	void ThreadPool::start(const int32_t count)
+	{
+		// The calling thread always participates, so N threads means N - 1 workers.
+		threadCount = count < 1 ? 1 : count;
+		stopping = false;
+		for (int32_t i = 0; i < threadCount - 1; i++) {
+			queues.push_back(new WorkQueue());
+		}
+		for (int32_t i = 0; i < threadCount - 1; i++) {
+			workers.push_back(std::thread(&ThreadPool::workerLoop, this, i));
+		}
+	}
+
+	void ThreadPool::stop()
+	{
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex);
+			stopping = true;
+		}
+		wake.notify_all();
+
+		for (std::thread& worker : workers) {
+			worker.join();
+		}
+		workers.clear();
+
+		for (WorkQueue* queue : queues) {
+			delete queue;
+		}
+		queues.clear();
+	}
+
+	void ThreadPool::parallelFor(const int32_t begin, const int32_t end, const int32_t grainSize, const RangeFunc& func)
+	{
+		const int32_t minGrain = minGrainSize.load();
+		run(begin, end, grainSize > minGrain ? grainSize : minGrain, func);
+	}
+
+	void ThreadPool::parallelForEach(const int32_t begin, const int32_t end, const RangeFunc& func)
+	{
+		run(begin, end, 1, func);
+	}
+
+	void ThreadPool::parallelForEach(const int32_t begin, const int32_t end, const int32_t grainSize, const RangeFunc& func)
+	{
+		run(begin, end, grainSize, func);
+	}
+
+	void ThreadPool::run(const int32_t begin, const int32_t end, const int32_t grainSize, const RangeFunc& func)
+	{
+		const int32_t length = end - begin;
+		if (length <= 0)
+			return;
+
+		int32_t grain = grainSize < 1 ? 1 : grainSize;
+		if (queues.empty() || length <= grain) {
+			func(begin, end);
+			return;
+		}
+
+		int32_t taskCount = (length + grain - 1) / grain;
+		const int32_t maxTasks = threadCount * TASKS_PER_THREAD;
+		if (taskCount > maxTasks) {
+			taskCount = maxTasks;
+			grain = (length + taskCount - 1) / taskCount;
+			taskCount = (length + grain - 1) / grain;
+		}
+
+		Job job;
+		job.func = &func;
+		job.remaining.store(taskCount);
+
+		// Spread every task but the first over the queues, starting at our own.
+		const int32_t queueCount = (int32_t)queues.size();
+		const int32_t home = currentWorker >= 0 ? currentWorker : (int32_t)(nextQueue.fetch_add(1) % (uint32_t)queueCount);
+		for (int32_t t = 1; t < taskCount; t++) {
+			Task task;
+			task.job = &job;
+			task.start = begin + (t * grain);
+			task.end = (task.start + grain) < end ? (task.start + grain) : end;
+
+			WorkQueue* queue = queues[(home + t) % queueCount];
+			std::lock_guard<std::mutex> lock(queue->mutex);
+			queue->tasks.push_back(task);
+		}
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex);
+			pending.fetch_add(taskCount - 1);
+		}
+		wake.notify_all();
+
+		// Run the first range here, then help out until every range of this job is done.
+		Task first;
+		first.job = &job;
+		first.start = begin;
+		first.end = (begin + grain) < end ? (begin + grain) : end;
+		runTask(first);
+
+		while (job.remaining.load(std::memory_order_acquire) > 0) {
+			if (!tryRunTask(home))
+				std::this_thread::yield();
+		}
+
+		if (job.error)
+			std::rethrow_exception(job.error);
+	}
+
+	void ThreadPool::workerLoop(const int32_t index)
+	{
+		currentWorker = index;
+		while (true) {
+			if (tryRunTask(index))
+				continue;
+
+			std::unique_lock<std::mutex> lock(sleepMutex);
+			wake.wait(lock, [this] { return stopping || pending.load() > 0; });
+			if (stopping && pending.load() == 0)
+				return;
+		}
+	}
+
+	const bool ThreadPool::tryRunTask(const int32_t queueIndex)
+	{
+		const int32_t queueCount = (int32_t)queues.size();
+		Task task;
+		bool found = false;
+
+		// Own queue first, newest task (still warm in cache).
+		{
+			WorkQueue* own = queues[queueIndex];
+			std::lock_guard<std::mutex> lock(own->mutex);
+			if (!own->tasks.empty()) {
+				task = own->tasks.back();
+				own->tasks.pop_back();
+				found = true;
+			}
+		}
+
+		// Steal the oldest task from another queue.
+		for (int32_t i = 1; !found && i < queueCount; i++) {
+			WorkQueue* victim = queues[(queueIndex + i) % queueCount];
+			std::lock_guard<std::mutex> lock(victim->mutex);
+			if (!victim->tasks.empty()) {
+				task = victim->tasks.front();
+				victim->tasks.pop_front();
+				found = true;
+			}
+		}
+
+		if (!found)
+			return false;
+
+		pending.fetch_sub(1);
+		runTask(task);
+		return true;
+	}
+
+	void ThreadPool::runTask(const Task& task)
+	{
+		Job* job = task.job;
+		try {
+			(*job->func)(task.start, task.end);
+		} catch (...) {
+			std::lock_guard<std::mutex> lock(job->errorMutex);
+			if (!job->error)
+				job->error = std::current_exception();
+		}
+
+		// The job lives on the waiting thread's stack. It must not be touched after this.
+		job->remaining.fetch_sub(1, std::memory_order_release);
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,89 @@
+#pragma once
+
+#ifndef UTILITY_THREADPOOL_H
+#define UTILITY_THREADPOOL_H
+
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Utility {
+
+	// Work-stealing pool used to split particle work into ranges. Every worker owns a deque:
+	// it pops its own tasks LIFO and steals from the other deques FIFO when it runs dry.
+	// Threads calling parallelFor() help execute tasks until their own job completes, so
+	// nested and concurrent calls (e.g. from managed worker threads) cannot deadlock.
+	class ThreadPool {
+	public:
+		typedef std::function<void(const int32_t start, const int32_t end)> RangeFunc;
+
+		static const int32_t DEFAULT_MIN_GRAIN_SIZE = 1024;
+
+		static ThreadPool& get();
+
+		const int32_t getThreadCount();
+		void setThreadCount(const int32_t count);
+		const int32_t getMinGrainSize();
+		void setMinGrainSize(const int32_t size);
+
+		// Calls func over disjoint subranges of [begin, end). Subranges are at least
+		// max(grainSize, minGrainSize) long, so small ranges run inline on the caller.
+		void parallelFor(const int32_t begin, const int32_t end, const int32_t grainSize, const RangeFunc& func);
+
+		// Like parallelFor, for coarse items such as whole emitters: ignores the minimum grain size.
+		void parallelForEach(const int32_t begin, const int32_t end, const RangeFunc& func);
+		void parallelForEach(const int32_t begin, const int32_t end, const int32_t grainSize, const RangeFunc& func);
+
+	private:
+		// Lives on the stack of the thread that called parallelFor, which waits for every task before
+		// returning, even when one throws. The first exception is rethrown there.
+		struct Job {
+			const RangeFunc* func;
+			std::atomic<int32_t> remaining;
+			std::mutex errorMutex;
+			std::exception_ptr error;
+		};
+
+		struct Task {
+			Job* job;
+			int32_t start;
+			int32_t end;
+		};
+
+		struct WorkQueue {
+			std::mutex mutex;
+			std::deque<Task> tasks;
+		};
+
+		std::vector<std::thread> workers;
+		std::vector<WorkQueue*> queues;
+		std::mutex sleepMutex;
+		std::condition_variable wake;
+		std::atomic<int32_t> pending;
+		std::atomic<uint32_t> nextQueue;
+		std::atomic<int32_t> minGrainSize;
+		bool stopping = false;
+		int32_t threadCount = 1;
+
+		ThreadPool();
+
+		void start(const int32_t count);
+		void stop();
+		void run(const int32_t begin, const int32_t end, const int32_t grainSize, const RangeFunc& func);
+		void workerLoop(const int32_t index);
+		const bool tryRunTask(const int32_t queueIndex);
+		void runTask(const Task& task);
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+	};
+
+}
+
+#endif
\ No newline at end of file